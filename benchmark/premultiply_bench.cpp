@@ -0,0 +1,77 @@
+// checks PremultiplyAlpha against c * a / 255 for every color and alpha pair,
+// then times it on a 2048x2048 image. The SIMD path is the one toy2d was
+// compiled with, build with and without TOY2D_ENABLE_AVX2 to cover both
+//   premultiply_bench [iterations]
+
+#include "toy2d/premultiply.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace {
+
+// the reference, rounded to nearest
+uint8_t expected(uint32_t c, uint32_t a) {
+    return static_cast<uint8_t>((c * a + 127) / 255);
+}
+
+// every (c, a) pair lands in each color channel. Odd counts and offsets
+// reach the scalar tail and unaligned SIMD loads
+bool checkAllPairs() {
+    std::vector<uint8_t> source;
+    for (uint32_t a = 0; a < 256; a++) {
+        for (uint32_t c = 0; c < 256; c++) {
+            source.push_back(c);
+            source.push_back(255 - c);
+            source.push_back(c ^ 0x55);
+            source.push_back(a);
+        }
+    }
+
+    for (size_t skip = 0; skip < 4; skip++) {
+        size_t count = source.size() / 4 - skip * 3;
+        std::vector<uint8_t> pixels(4 + source.size());
+        std::copy(source.begin(), source.begin() + count * 4, pixels.begin() + skip * 4 + skip);
+        uint8_t* data = pixels.data() + skip * 4 + skip;
+        toy2d::PremultiplyAlpha(data, count);
+
+        for (size_t i = 0; i < count; i++) {
+            const uint8_t* in = source.data() + i * 4;
+            const uint8_t* out = data + i * 4;
+            if (out[0] != expected(in[0], in[3]) || out[1] != expected(in[1], in[3]) ||
+                out[2] != expected(in[2], in[3]) || out[3] != in[3]) {
+                std::cout << "mismatch at pixel " << i << ", offset " << skip << std::endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+}
+
+int main(int argc, char** argv) {
+    if (!checkAllPairs()) {
+        return 1;
+    }
+    std::cout << "all color and alpha pairs match" << std::endl;
+
+    int iterations = argc > 1 ? std::max(1, std::atoi(argv[1])) : 20;
+    constexpr size_t Size = 2048;
+    std::vector<uint8_t> pixels(Size * Size * 4);
+    std::mt19937 random;
+    for (auto& value : pixels) {
+        value = static_cast<uint8_t>(random());
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        toy2d::PremultiplyAlpha(pixels.data(), Size * Size);
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - begin;
+    std::cout << Size << "x" << Size << ": " << elapsed.count() / iterations << " ms" << std::endl;
+    return 0;
+}
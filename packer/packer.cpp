@@ -0,0 +1,138 @@
+// packs images into an asset archive, see toy2d/asset_archive.hpp
+//   packer <archive> <image>...
+// Images are looked up by the path given here, with '/' as separator.
+// .ktx2 and .dds files keep their compressed blocks, everything else is
+// decoded to premultiplied RGBA8 now so loading the archive doesn't decode anything.
+
+#include "toy2d/asset_archive.hpp"
+#include "toy2d/compressed_image.hpp"
+#include "toy2d/premultiply.hpp"
+#include "toy2d/stb_image.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <string>
+
+struct Asset {
+    std::string name;
+    toy2d::ArchiveEntry entry;
+    std::vector<char> data;
+};
+
+Asset loadAsset(const std::string& filename) {
+    Asset asset;
+    asset.name = filename;
+    std::replace(asset.name.begin(), asset.name.end(), '\\', '/');
+    asset.entry = {};
+
+    if (toy2d::IsCompressedImageFile(filename)) {
+        auto image = toy2d::LoadCompressedImage(filename);
+        asset.entry.format = static_cast<uint32_t>(image.format);
+        asset.entry.width = image.width;
+        asset.entry.height = image.height;
+        asset.entry.levelCount = image.levels.size();
+        for (auto& level : image.levels) {
+            asset.data.insert(asset.data.end(),
+                              image.file.Data() + level.offset,
+                              image.file.Data() + level.offset + level.size);
+        }
+        return asset;
+    }
+
+    int w, h, channel;
+    stbi_uc* pixels = stbi_load(filename.c_str(), &w, &h, &channel, STBI_rgb_alpha);
+    if (!pixels) {
+        throw std::runtime_error("image load failed: " + filename);
+    }
+    toy2d::PremultiplyAlpha(pixels, size_t(w) * h);
+    asset.entry.format = static_cast<uint32_t>(vk::Format::eR8G8B8A8Srgb);
+    asset.entry.width = w;
+    asset.entry.height = h;
+    asset.entry.levelCount = 1;
+    asset.data.assign(reinterpret_cast<char*>(pixels), reinterpret_cast<char*>(pixels) + size_t(w) * h * 4);
+    stbi_image_free(pixels);
+    return asset;
+}
+
+uint64_t align(uint64_t offset) {
+    return (offset + toy2d::ArchiveAlignment - 1) / toy2d::ArchiveAlignment * toy2d::ArchiveAlignment;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cout << "usage: packer <archive> <image>..." << std::endl;
+        return 1;
+    }
+
+    std::vector<Asset> assets;
+    try {
+        for (int i = 2; i < argc; i++) {
+            assets.push_back(loadAsset(argv[i]));
+        }
+    } catch (const std::exception& e) {
+        std::cout << e.what() << std::endl;
+        return 1;
+    }
+
+    toy2d::ArchiveHeader header = {};
+    std::copy(std::begin(toy2d::ArchiveMagic), std::end(toy2d::ArchiveMagic), header.magic);
+    header.version = toy2d::ArchiveVersion;
+    header.entryCount = assets.size();
+    header.bucketCount = 1;
+    // at most half full, so probes stay short
+    while (header.bucketCount < assets.size() * 2) {
+        header.bucketCount *= 2;
+    }
+    header.entriesOffset = sizeof(toy2d::ArchiveHeader);
+    header.bucketsOffset = header.entriesOffset + assets.size() * sizeof(toy2d::ArchiveEntry);
+
+    std::vector<uint32_t> buckets(header.bucketCount, toy2d::ArchiveEmptyBucket);
+    uint64_t offset = header.bucketsOffset + buckets.size() * sizeof(uint32_t);
+    for (uint32_t i = 0; i < assets.size(); i++) {
+        auto& asset = assets[i];
+        asset.entry.nameHash = toy2d::HashAssetName(asset.name);
+        asset.entry.nameOffset = offset;
+        asset.entry.nameLength = asset.name.size();
+        offset += asset.name.size();
+
+        uint32_t mask = header.bucketCount - 1;
+        uint32_t bucket = asset.entry.nameHash & mask;
+        while (buckets[bucket] != toy2d::ArchiveEmptyBucket) {
+            if (assets[buckets[bucket]].name == asset.name) {
+                std::cout << "packed twice: " << asset.name << std::endl;
+                return 1;
+            }
+            bucket = (bucket + 1) & mask;
+        }
+        buckets[bucket] = i;
+    }
+    for (auto& asset : assets) {
+        offset = align(offset);
+        asset.entry.dataOffset = offset;
+        asset.entry.dataSize = asset.data.size();
+        offset += asset.data.size();
+    }
+
+    std::ofstream file(argv[1], std::ios::binary);
+    if (!file) {
+        std::cout << "open " << argv[1] << " failed" << std::endl;
+        return 1;
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (auto& asset : assets) {
+        file.write(reinterpret_cast<const char*>(&asset.entry), sizeof(asset.entry));
+    }
+    file.write(reinterpret_cast<const char*>(buckets.data()), buckets.size() * sizeof(uint32_t));
+    for (auto& asset : assets) {
+        file.write(asset.name.data(), asset.name.size());
+    }
+    for (auto& asset : assets) {
+        std::vector<char> padding(asset.entry.dataOffset - static_cast<uint64_t>(file.tellp()), 0);
+        file.write(padding.data(), padding.size());
+        file.write(asset.data.data(), asset.data.size());
+    }
+
+    std::cout << "packed " << assets.size() << " images into " << argv[1] << std::endl;
+    return 0;
+}
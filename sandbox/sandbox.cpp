@@ -46,6 +46,12 @@ int main(int argc, char** argv) {
 
     float x = 100, y = 100;
 
+    // --texture-cache <dir> keeps decoded images between runs
+    for (int i = 1; i + 1 < argc; i++) {
+        if (std::string(argv[i]) == "--texture-cache") {
+            toy2d::TextureManager::Instance().SetDiskCache(argv[i + 1]);
+        }
+    }
     toy2d::Texture* texture1 = toy2d::LoadTexture("resources/role.png");
     toy2d::Texture* texture2 = toy2d::LoadTexture("resources/texture.jpg");
 
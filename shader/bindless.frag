@@ -0,0 +1,13 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+layout(location = 0) out vec4 outColor;
+layout(location = 0) in vec2 Texcoord;
+layout(location = 1) in vec3 Color;
+layout(location = 2) flat in uint TextureIndex;
+
+layout(set = 2, binding = 0) uniform sampler2D Textures[];
+
+void main() {
+    outColor = vec4(Color, 1.0) * texture(Textures[nonuniformEXT(TextureIndex)], Texcoord);
+}
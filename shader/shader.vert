@@ -2,8 +2,10 @@
 
 layout(location = 0) in vec2 inPosition;
 layout(location = 1) in vec2 inTexcoord;
+layout(location = 2) in vec3 inColor;
 
 layout(location = 0) out vec2 outTexcoord;
+layout(location = 1) out vec3 outColor;
 
 layout(set = 0, binding = 0) uniform UniformBuffer {
     mat4 project;
@@ -17,4 +19,5 @@ layout(push_constant) uniform PushConstant {
 void main() {
     gl_Position = ubo.project * ubo.view * pc.model * vec4(inPosition, 0.0, 1.0);
     outTexcoord = inTexcoord;
+    outColor = inColor;
 }
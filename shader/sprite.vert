@@ -0,0 +1,29 @@
+#version 450
+
+// unit quad, shared by every instance
+layout(location = 0) in vec2 inPosition;
+layout(location = 1) in vec2 inTexcoord;
+
+// per-instance data
+layout(location = 2) in vec2 inInstancePosition;
+layout(location = 3) in vec2 inInstanceSize;
+layout(location = 4) in vec4 inInstanceUV;
+layout(location = 5) in vec4 inInstanceColor;
+layout(location = 6) in uint inInstanceTexture;
+
+layout(location = 0) out vec2 outTexcoord;
+layout(location = 1) out vec3 outColor;
+layout(location = 2) flat out uint outTexture;
+
+layout(set = 0, binding = 0) uniform UniformBuffer {
+    mat4 project;
+    mat4 view;
+} ubo;
+
+void main() {
+    vec2 position = inInstancePosition + inPosition * inInstanceSize;
+    gl_Position = ubo.project * ubo.view * vec4(position, 0.0, 1.0);
+    outTexcoord = inInstanceUV.xy + inTexcoord * inInstanceUV.zw;
+    outColor = inInstanceColor.rgb;
+    outTexture = inInstanceTexture;
+}
@@ -0,0 +1,76 @@
+#include "toy2d/asset_archive.hpp"
+#include "toy2d/compressed_image.hpp"
+#include <cstring>
+#include <stdexcept>
+
+namespace toy2d {
+
+uint64_t HashAssetName(std::string_view name) {
+    uint64_t hash = 14695981039346656037ull;
+    for (char c : name) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+AssetArchive::AssetArchive(const std::string& filename)
+    : filename_(filename), file_(filename, MappedFile::Access::Random) {
+    if (file_.Size() < sizeof(ArchiveHeader)) {
+        throw std::runtime_error("asset archive load failed");
+    }
+
+    header_ = reinterpret_cast<const ArchiveHeader*>(file_.Data());
+    if (memcmp(header_->magic, ArchiveMagic, sizeof(ArchiveMagic)) != 0 || header_->version != ArchiveVersion) {
+        throw std::runtime_error("not an asset archive of this version");
+    }
+
+    // the mapping is page aligned, aligned offsets make the tables safe to read in place.
+    // The packer keeps at least half of the buckets empty
+    auto& header = *header_;
+    if (header.entriesOffset % alignof(ArchiveEntry) != 0 || header.bucketsOffset % alignof(uint32_t) != 0 ||
+        !inRange(header.entriesOffset, uint64_t(header.entryCount) * sizeof(ArchiveEntry)) ||
+        !inRange(header.bucketsOffset, uint64_t(header.bucketCount) * sizeof(uint32_t)) ||
+        header.bucketCount == 0 || (header.bucketCount & (header.bucketCount - 1)) != 0 ||
+        uint64_t(header.entryCount) * 2 > header.bucketCount) {
+        throw std::runtime_error("asset archive is corrupted");
+    }
+    entries_ = reinterpret_cast<const ArchiveEntry*>(file_.Data() + header_->entriesOffset);
+    buckets_ = reinterpret_cast<const uint32_t*>(file_.Data() + header_->bucketsOffset);
+
+    for (uint32_t i = 0; i < header_->entryCount; i++) {
+        auto& entry = entries_[i];
+        if (!inRange(entry.nameOffset, entry.nameLength) || !inRange(entry.dataOffset, entry.dataSize) ||
+            entry.dataSize == 0 || entry.width == 0 || entry.height == 0 || entry.levelCount == 0 ||
+            entry.levelCount > MaxLevelCount(entry.width, entry.height)) {
+            throw std::runtime_error("asset archive is corrupted");
+        }
+    }
+    for (uint32_t i = 0; i < header_->bucketCount; i++) {
+        if (buckets_[i] != ArchiveEmptyBucket && buckets_[i] >= header_->entryCount) {
+            throw std::runtime_error("asset archive is corrupted");
+        }
+    }
+}
+
+bool AssetArchive::inRange(uint64_t offset, uint64_t size) const {
+    // offsets come from the file, adding them could wrap
+    return offset <= file_.Size() && size <= file_.Size() - offset;
+}
+
+const ArchiveEntry* AssetArchive::Find(std::string_view name) const {
+    uint64_t hash = HashAssetName(name);
+    uint32_t mask = header_->bucketCount - 1;
+    // linear probing, the packer keeps at least half of the buckets empty. A corrupt
+    // table may have none, the probe stops after visiting every bucket then
+    uint32_t i = hash & mask;
+    for (uint32_t step = 0; step < header_->bucketCount && buckets_[i] != ArchiveEmptyBucket; step++, i = (i + 1) & mask) {
+        auto& entry = entries_[buckets_[i]];
+        if (entry.nameHash == hash && GetName(entry) == name) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+}
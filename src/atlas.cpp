@@ -0,0 +1,89 @@
+#include "toy2d/atlas.hpp"
+#include <algorithm>
+#include <limits>
+
+namespace toy2d {
+
+SkylinePacker::SkylinePacker(uint32_t width, uint32_t height): width_(width), height_(height) {
+    skyline_.push_back({0, 0, width});
+}
+
+bool SkylinePacker::Pack(uint32_t w, uint32_t h, uint32_t& x, uint32_t& y) {
+    size_t bestIndex = skyline_.size();
+    uint32_t bestBottom = std::numeric_limits<uint32_t>::max();
+    uint32_t bestWidth = std::numeric_limits<uint32_t>::max();
+
+    for (size_t i = 0; i < skyline_.size(); i++) {
+        uint32_t top;
+        if (!fit(i, w, h, top)) {
+            continue;
+        }
+        // lowest bottom edge first, then the narrowest segment to waste less space
+        if (top + h < bestBottom || (top + h == bestBottom && skyline_[i].w < bestWidth)) {
+            bestIndex = i;
+            bestBottom = top + h;
+            bestWidth = skyline_[i].w;
+            y = top;
+        }
+    }
+
+    if (bestIndex == skyline_.size()) {
+        return false;
+    }
+
+    x = skyline_[bestIndex].x;
+    addLevel(bestIndex, x, y, w, h);
+    return true;
+}
+
+bool SkylinePacker::fit(size_t index, uint32_t w, uint32_t h, uint32_t& y) const {
+    uint32_t x = skyline_[index].x;
+    if (x + w > width_) {
+        return false;
+    }
+
+    y = 0;
+    uint32_t remain = w;
+    for (size_t i = index; remain > 0; i++) {
+        // x + w <= width_ and the skyline covers the whole width, so i stays in range
+        y = std::max(y, skyline_[i].y);
+        if (y + h > height_) {
+            return false;
+        }
+        remain -= std::min(remain, skyline_[i].w);
+    }
+    return true;
+}
+
+void SkylinePacker::addLevel(size_t index, uint32_t x, uint32_t y, uint32_t w, uint32_t h) {
+    skyline_.insert(skyline_.begin() + index, Node{x, y + h, w});
+
+    // cut away the segments now hidden under the new one
+    for (size_t i = index + 1; i < skyline_.size();) {
+        auto& prev = skyline_[i - 1];
+        auto& node = skyline_[i];
+        if (node.x >= prev.x + prev.w) {
+            break;
+        }
+        uint32_t shrink = prev.x + prev.w - node.x;
+        if (shrink >= node.w) {
+            skyline_.erase(skyline_.begin() + i);
+            continue;
+        }
+        node.x += shrink;
+        node.w -= shrink;
+        break;
+    }
+
+    // merge neighbours at the same height
+    for (size_t i = 0; i + 1 < skyline_.size();) {
+        if (skyline_[i].y == skyline_[i + 1].y) {
+            skyline_[i].w += skyline_[i + 1].w;
+            skyline_.erase(skyline_.begin() + i + 1);
+        } else {
+            i++;
+        }
+    }
+}
+
+}
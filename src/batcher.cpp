@@ -0,0 +1,250 @@
+#include "toy2d/batcher.hpp"
+#include "toy2d/context.hpp"
+#include <cmath>
+
+namespace toy2d {
+
+void Batcher::Begin(vk::CommandBuffer cmd, const FrameResources& resources) {
+    stateCache_.Begin(cmd);
+    resources_ = resources;
+    instances_.clear();
+    texture_ = nullptr;
+    lineVertices_.clear();
+    spriteRects_.Clear();
+    lineRects_.Clear();
+    cullStats_ = CullStats{};
+}
+
+void Batcher::SetBindless(bool bindless) {
+    if (bindless != resources_.bindless) {
+        flushSprites();
+        resources_.bindless = bindless;
+    }
+}
+
+void Batcher::AddSprite(const SpriteInstance& instance, Texture& texture) {
+    flushLines();
+    // with the bindless table every instance carries its own texture, nothing to break on.
+    // Compare sets instead of textures, textures in the same atlas page share theirs
+    if (!resources_.bindless && (!texture_ || texture_->set.set != texture.set.set)) {
+        flushSprites();
+        texture_ = &texture;
+    }
+    instances_.push_back(instance);
+    if (resources_.culling) {
+        spriteRects_.Push(instance.position.x, instance.position.y,
+                          std::abs(instance.size.w) * 0.5f, std::abs(instance.size.h) * 0.5f);
+    }
+}
+
+void Batcher::AddLine(const Vertex& p1, const Vertex& p2) {
+    flushSprites();
+    lineVertices_.push_back(p1);
+    lineVertices_.push_back(p2);
+    if (resources_.culling) {
+        lineRects_.Push((p1.position.x + p2.position.x) * 0.5f, (p1.position.y + p2.position.y) * 0.5f,
+                        std::abs(p1.position.x - p2.position.x) * 0.5f, std::abs(p1.position.y - p2.position.y) * 0.5f);
+    }
+}
+
+void Batcher::AddIndirect(const DrawList::IndirectData& indirect) {
+    Flush();
+
+    bindSprites(indirect.instances);
+    if (!resources_.bindless) {
+        stateCache_.BindDescriptorSet(1, indirect.texture->set.set);
+    }
+    stateCache_.DrawIndexedIndirect(indirect.drawCommand, 0, 1, sizeof(vk::DrawIndexedIndirectCommand));
+}
+
+void Batcher::AddScene(const SpriteScene& scene) {
+    Flush();
+    if (scene.GetCount() == 0) {
+        return;
+    }
+
+    if (resources_.culling) {
+        visibleIndices_.clear();
+        scene.GatherVisible(resources_.bounds, visibleIndices_);
+        cullStats_.drawn += visibleIndices_.size();
+        cullStats_.culled += scene.GetCount() - visibleIndices_.size();
+
+        // when most of the scene is visible drawing its buffer as a whole is cheaper,
+        // otherwise copy the few visible sprites like a normal batch
+        if (visibleIndices_.size() * 2 < scene.GetCount()) {
+            auto& instances = scene.GetInstances();
+            auto& textures = scene.GetTextures();
+            for (auto index : visibleIndices_) {
+                if (!resources_.bindless && (!texture_ || texture_->set.set != textures[index]->set.set)) {
+                    drawSprites();
+                    texture_ = textures[index];
+                }
+                instances_.push_back(instances[index]);
+            }
+            drawSprites();
+            return;
+        }
+    }
+
+    bindSprites(scene.GetBuffer());
+    if (resources_.bindless) {
+        stateCache_.DrawIndexed(6, scene.GetCount(), 0, 0, 0);
+        return;
+    }
+
+    // one draw per run of sprites sharing a descriptor set
+    auto& textures = scene.GetTextures();
+    uint32_t first = 0;
+    while (first < textures.size()) {
+        uint32_t last = first + 1;
+        while (last < textures.size() && textures[last]->set.set == textures[first]->set.set) {
+            last++;
+        }
+        stateCache_.BindDescriptorSet(1, textures[first]->set.set);
+        stateCache_.DrawIndexed(6, last - first, 0, 0, first);
+        first = last;
+    }
+}
+
+void Batcher::bindSprites(vk::Buffer instances) {
+    auto& ctx = Context::Instance();
+    if (resources_.bindless) {
+        stateCache_.BindPipeline(ctx.renderProcess->graphicsPipelineWithBindlessTexture, ctx.renderProcess->layout);
+    } else {
+        stateCache_.BindPipeline(ctx.renderProcess->graphicsPipelineWithTriangleTopology, ctx.renderProcess->layout);
+    }
+    stateCache_.BindVertexBuffer(0, resources_.rectVertices->buffer, 0);
+    stateCache_.BindVertexBuffer(1, instances, 0);
+    stateCache_.BindIndexBuffer(resources_.rectIndices->buffer, 0, vk::IndexType::eUint32);
+    stateCache_.BindDescriptorSet(0, resources_.uniformSet);
+    if (resources_.bindless) {
+        stateCache_.BindDescriptorSet(2, DescriptorSetManager::Instance().GetTextureTableSet());
+    }
+}
+
+void Batcher::Record(DrawList& drawList) {
+    if (drawList.Empty()) {
+        return;
+    }
+
+    drawList.Sort();
+    for (auto& packet : drawList.GetPackets()) {
+        switch (DrawList::GetPipeline(packet)) {
+            case DrawList::Pipeline::Sprite: {
+                auto& sprite = drawList.GetSprite(packet);
+                AddSprite(sprite.instance, *sprite.texture);
+                break;
+            }
+            case DrawList::Pipeline::Line: {
+                auto& line = drawList.GetLine(packet);
+                AddLine(line.p1, line.p2);
+                break;
+            }
+            case DrawList::Pipeline::SpriteBuffer:
+                AddIndirect(drawList.GetIndirect(packet));
+                break;
+            case DrawList::Pipeline::SpriteScene:
+                AddScene(*drawList.GetScene(packet));
+                break;
+        }
+    }
+    drawList.Clear();
+}
+
+void Batcher::Flush() {
+    flushSprites();
+    flushLines();
+}
+
+template <typename T>
+size_t Batcher::cull(const RectArrays& rects, std::vector<T>& elements, size_t elementsPerRect) {
+    visible_.resize(rects.Size());
+    size_t visibleCount = CullRects(rects, resources_.bounds, visible_.data());
+    cullStats_.drawn += visibleCount;
+    cullStats_.culled += rects.Size() - visibleCount;
+
+    if (visibleCount != rects.Size()) {
+        // keep visible elements in order
+        size_t dst = 0;
+        for (size_t i = 0; i < rects.Size(); i++) {
+            if (visible_[i]) {
+                for (size_t j = 0; j < elementsPerRect; j++) {
+                    elements[dst++] = elements[i * elementsPerRect + j];
+                }
+            }
+        }
+        elements.resize(dst);
+    }
+    return visibleCount;
+}
+
+void Batcher::flushSprites() {
+    if (instances_.empty()) {
+        return;
+    }
+
+    if (resources_.culling) {
+        cull(spriteRects_, instances_, 1);
+        spriteRects_.Clear();
+    }
+    drawSprites();
+}
+
+void Batcher::drawSprites() {
+    if (instances_.empty()) {
+        texture_ = nullptr;
+        return;
+    }
+
+    // instance-sized alignment lets every batch bind the allocator buffer at offset 0
+    // and select its range through firstInstance, so the vertex buffer bind is shared
+    auto instances = bufferFrameData(instances_.data(),
+                                     instances_.size() * sizeof(SpriteInstance),
+                                     sizeof(SpriteInstance));
+
+    bindSprites(instances.buffer);
+    if (!resources_.bindless) {
+        stateCache_.BindDescriptorSet(1, texture_->set.set);
+    }
+    stateCache_.DrawIndexed(6, instances_.size(), 0, 0, instances.offset / sizeof(SpriteInstance));
+
+    instances_.clear();
+    texture_ = nullptr;
+}
+
+void Batcher::flushLines() {
+    if (lineVertices_.empty()) {
+        return;
+    }
+
+    if (resources_.culling) {
+        size_t visibleCount = cull(lineRects_, lineVertices_, 2);
+        lineRects_.Clear();
+        if (visibleCount == 0) {
+            return;
+        }
+    }
+
+    auto& ctx = Context::Instance();
+    auto vertices = bufferFrameData(lineVertices_.data(),
+                                    lineVertices_.size() * sizeof(Vertex),
+                                    sizeof(Vertex));
+
+    stateCache_.BindPipeline(ctx.renderProcess->graphicsPipelineWithLineTopology, ctx.renderProcess->layout);
+    stateCache_.BindVertexBuffer(0, vertices.buffer, 0);
+    stateCache_.BindDescriptorSet(0, resources_.uniformSet);
+    stateCache_.BindDescriptorSet(1, resources_.whiteTexture->set.set);
+    auto model = Mat4::CreateIdentity();
+    stateCache_.PushConstants(vk::ShaderStageFlagBits::eVertex, 0, sizeof(Mat4), model.GetData());
+    stateCache_.Draw(lineVertices_.size(), 1, vertices.offset / sizeof(Vertex), 0);
+
+    lineVertices_.clear();
+}
+
+FrameAllocator::Allocation Batcher::bufferFrameData(const void* data, size_t size, size_t alignment) {
+    auto allocation = resources_.allocator->Allocate(size, alignment);
+    memcpy(allocation.map, data, size);
+    return allocation;
+}
+
+}
@@ -3,8 +3,11 @@
 
 namespace toy2d {
 
-CommandManager::CommandManager() {
-    pool_ = createCommandPool();
+CommandManager::CommandManager()
+    : CommandManager(Context::Instance().queueInfo.graphicsIndex.value()) {}
+
+CommandManager::CommandManager(std::uint32_t queueFamilyIndex) {
+    pool_ = createCommandPool(queueFamilyIndex);
 }
 
 CommandManager::~CommandManager() {
@@ -16,24 +19,24 @@ void CommandManager::ResetCmds() {
     Context::Instance().device.resetCommandPool(pool_);
 }
 
-vk::CommandPool CommandManager::createCommandPool() {
+vk::CommandPool CommandManager::createCommandPool(std::uint32_t queueFamilyIndex) {
     auto& ctx = Context::Instance();
 
     vk::CommandPoolCreateInfo createInfo;
 
-    createInfo.setQueueFamilyIndex(ctx.queueInfo.graphicsIndex.value())
+    createInfo.setQueueFamilyIndex(queueFamilyIndex)
               .setFlags(vk::CommandPoolCreateFlagBits::eResetCommandBuffer);
 
     return ctx.device.createCommandPool(createInfo);
 }
 
-std::vector<vk::CommandBuffer> CommandManager::CreateCommandBuffers(std::uint32_t count) {
+std::vector<vk::CommandBuffer> CommandManager::CreateCommandBuffers(std::uint32_t count, vk::CommandBufferLevel level) {
     auto& ctx = Context::Instance();
 
     vk::CommandBufferAllocateInfo allocInfo;
     allocInfo.setCommandPool(pool_)
-             .setCommandBufferCount(1)
-             .setLevel(vk::CommandBufferLevel::ePrimary);
+             .setCommandBufferCount(count)
+             .setLevel(level);
 
     return ctx.device.allocateCommandBuffers(allocInfo);
 }
@@ -0,0 +1,209 @@
+#include "toy2d/compressed_image.hpp"
+#include <algorithm>
+#include <cstring>
+#include <cctype>
+#include <stdexcept>
+
+namespace toy2d {
+
+namespace {
+
+template <typename T>
+T read(std::string_view data, size_t offset) {
+    if (offset + sizeof(T) > data.size()) {
+        throw std::runtime_error("compressed image truncated");
+    }
+    T value;
+    memcpy(&value, data.data() + offset, sizeof(T));
+    return value;
+}
+
+bool endsWith(const std::string& str, const std::string& suffix) {
+    if (str.size() < suffix.size()) {
+        return false;
+    }
+    return std::equal(suffix.rbegin(), suffix.rend(), str.rbegin(),
+                      [](char a, char b) { return a == std::tolower(b); });
+}
+
+// bytes per 4x4 block, 0 for formats we don't load
+uint32_t blockSize(vk::Format format) {
+    switch (format) {
+        case vk::Format::eBc1RgbUnormBlock:
+        case vk::Format::eBc1RgbSrgbBlock:
+        case vk::Format::eBc1RgbaUnormBlock:
+        case vk::Format::eBc1RgbaSrgbBlock:
+        case vk::Format::eEtc2R8G8B8UnormBlock:
+        case vk::Format::eEtc2R8G8B8SrgbBlock:
+        case vk::Format::eEtc2R8G8B8A1UnormBlock:
+        case vk::Format::eEtc2R8G8B8A1SrgbBlock:
+            return 8;
+        case vk::Format::eBc3UnormBlock:
+        case vk::Format::eBc3SrgbBlock:
+        case vk::Format::eBc7UnormBlock:
+        case vk::Format::eBc7SrgbBlock:
+        case vk::Format::eEtc2R8G8B8A8UnormBlock:
+        case vk::Format::eEtc2R8G8B8A8SrgbBlock:
+            return 16;
+        default:
+            return 0;
+    }
+}
+
+void checkExtent(const CompressedImage& image, uint32_t levelCount) {
+    if (image.width == 0 || image.height == 0) {
+        throw std::runtime_error("compressed image has no size");
+    }
+    if (levelCount > MaxLevelCount(image.width, image.height)) {
+        throw std::runtime_error("compressed image has more levels than its size allows");
+    }
+}
+
+// offset and size come from the file, the sum could wrap
+bool inRange(std::string_view data, uint64_t offset, uint64_t size) {
+    return offset <= data.size() && size <= data.size() - offset;
+}
+
+CompressedImage loadKtx2(MappedFile file) {
+    // https://registry.khronos.org/KTX/specs/2.0/ktxspec.v2.html
+    auto data = file.View();
+    CompressedImage image;
+    image.format = static_cast<vk::Format>(read<uint32_t>(data, 12));
+    image.width = read<uint32_t>(data, 20);
+    image.height = read<uint32_t>(data, 24);
+    uint32_t depth = read<uint32_t>(data, 28);
+    uint32_t layerCount = read<uint32_t>(data, 32);
+    uint32_t faceCount = read<uint32_t>(data, 36);
+    uint32_t levelCount = std::max(1u, read<uint32_t>(data, 40));
+    uint32_t supercompression = read<uint32_t>(data, 44);
+
+    if (blockSize(image.format) == 0) {
+        throw std::runtime_error("ktx2 format not supported");
+    }
+    if (depth > 1 || layerCount > 1 || faceCount != 1 || supercompression != 0) {
+        throw std::runtime_error("only plain 2D ktx2 images are supported");
+    }
+    checkExtent(image, levelCount);
+
+    // the level index follows the 80 byte header, level 0 first
+    for (uint32_t i = 0; i < levelCount; i++) {
+        // checked as read, size_t may be narrower
+        uint64_t offset = read<uint64_t>(data, 80 + i * 24);
+        uint64_t size = read<uint64_t>(data, 80 + i * 24 + 8);
+        CompressedImage::Level level;
+        level.width = std::max(1u, image.width >> i);
+        level.height = std::max(1u, image.height >> i);
+        if (!inRange(data, offset, size) ||
+            size != ImageLevelSize(image.format, level.width, level.height)) {
+            throw std::runtime_error("ktx2 level out of range");
+        }
+        level.offset = static_cast<size_t>(offset);
+        level.size = static_cast<size_t>(size);
+        image.levels.push_back(level);
+    }
+
+    image.file = std::move(file);
+    return image;
+}
+
+CompressedImage loadDds(MappedFile file) {
+    constexpr uint32_t HeaderSize = 4 + 124;
+    constexpr uint32_t Dx10HeaderSize = 20;
+
+    auto data = file.View();
+    CompressedImage image;
+    image.height = read<uint32_t>(data, 12);
+    image.width = read<uint32_t>(data, 16);
+    // the mip count is only valid with DDSD_MIPMAPCOUNT set
+    constexpr uint32_t MipmapCountFlag = 0x20000;
+    uint32_t levelCount = 1;
+    if (read<uint32_t>(data, 8) & MipmapCountFlag) {
+        levelCount = std::max(1u, read<uint32_t>(data, 28));
+    }
+    uint32_t fourCC = read<uint32_t>(data, 84);
+
+    auto makeFourCC = [](const char* code) {
+        return static_cast<uint32_t>(code[0]) | static_cast<uint32_t>(code[1]) << 8 |
+               static_cast<uint32_t>(code[2]) << 16 | static_cast<uint32_t>(code[3]) << 24;
+    };
+
+    size_t offset = HeaderSize;
+    // legacy headers carry no color space, our images are sRGB
+    if (fourCC == makeFourCC("DXT1")) {
+        image.format = vk::Format::eBc1RgbaSrgbBlock;
+    } else if (fourCC == makeFourCC("DXT5")) {
+        image.format = vk::Format::eBc3SrgbBlock;
+    } else if (fourCC == makeFourCC("DX10")) {
+        switch (read<uint32_t>(data, HeaderSize)) {  // DXGI_FORMAT
+            case 71: image.format = vk::Format::eBc1RgbaUnormBlock; break;
+            case 72: image.format = vk::Format::eBc1RgbaSrgbBlock; break;
+            case 77: image.format = vk::Format::eBc3UnormBlock; break;
+            case 78: image.format = vk::Format::eBc3SrgbBlock; break;
+            case 98: image.format = vk::Format::eBc7UnormBlock; break;
+            case 99: image.format = vk::Format::eBc7SrgbBlock; break;
+            default: throw std::runtime_error("dds format not supported");
+        }
+        if (read<uint32_t>(data, HeaderSize + 12) > 1) {
+            throw std::runtime_error("only plain 2D dds images are supported");
+        }
+        offset += Dx10HeaderSize;
+    } else {
+        throw std::runtime_error("dds format not supported");
+    }
+    checkExtent(image, levelCount);
+
+    // levels are stored one after another, level 0 first
+    for (uint32_t i = 0; i < levelCount; i++) {
+        CompressedImage::Level level;
+        level.width = std::max(1u, image.width >> i);
+        level.height = std::max(1u, image.height >> i);
+        level.offset = offset;
+        level.size = ImageLevelSize(image.format, level.width, level.height);
+        if (!inRange(data, level.offset, level.size)) {
+            throw std::runtime_error("dds level out of range");
+        }
+        image.levels.push_back(level);
+        offset += level.size;
+    }
+
+    image.file = std::move(file);
+    return image;
+}
+
+}
+
+uint32_t MaxLevelCount(uint32_t w, uint32_t h) {
+    uint32_t size = std::max(w, h);
+    uint32_t count = 1;
+    while (size >>= 1) {
+        count++;
+    }
+    return count;
+}
+
+size_t ImageLevelSize(vk::Format format, uint32_t w, uint32_t h) {
+    if (format == vk::Format::eR8G8B8A8Srgb) {
+        return static_cast<size_t>(w) * h * 4;
+    }
+    size_t blocksX = std::max<size_t>(1, (static_cast<size_t>(w) + 3) / 4);
+    size_t blocksY = std::max<size_t>(1, (static_cast<size_t>(h) + 3) / 4);
+    return blocksX * blocksY * blockSize(format);
+}
+
+bool IsCompressedImageFile(const std::string& filename) {
+    return endsWith(filename, ".ktx2") || endsWith(filename, ".dds");
+}
+
+CompressedImage LoadCompressedImage(const std::string& filename) {
+    MappedFile file(filename);
+    static const char ktx2Identifier[12] = {'\xAB', 'K', 'T', 'X', ' ', '2', '0', '\xBB', '\r', '\n', '\x1A', '\n'};
+    if (file.Size() >= 80 && memcmp(file.Data(), ktx2Identifier, sizeof(ktx2Identifier)) == 0) {
+        return loadKtx2(std::move(file));
+    }
+    if (file.Size() >= 128 && memcmp(file.Data(), "DDS ", 4) == 0) {
+        return loadDds(std::move(file));
+    }
+    throw std::runtime_error("image load failed");
+}
+
+}
@@ -41,6 +41,7 @@ Context::Context(std::vector<const char*>& extensions, GetSurfaceCallback cb) {
 
     graphicsQueue = device.getQueue(queueInfo.graphicsIndex.value(), 0);
     presentQueue = device.getQueue(queueInfo.presentIndex.value(), 0);
+    transferQueue = device.getQueue(queueInfo.transferIndex.value(), 0);
 }
 
 void Context::getSurface() {
@@ -83,22 +84,37 @@ vk::Device Context::createDevice(vk::SurfaceKHR surface) {
     std::array extensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
     deviceCreateInfo.setPEnabledExtensionNames(extensions);
 
+    vk::PhysicalDeviceVulkan12Features vulkan12Features;
+    queryBindlessInfo();
+    if (bindlessInfo.supported) {
+        vulkan12Features.setRuntimeDescriptorArray(true)
+                        .setShaderSampledImageArrayNonUniformIndexing(true)
+                        .setDescriptorBindingPartiallyBound(true)
+                        .setDescriptorBindingSampledImageUpdateAfterBind(true)
+                        .setDescriptorBindingUpdateUnusedWhilePending(true);
+    }
+    queryTimelineInfo();
+    if (timelineSupported) {
+        vulkan12Features.setTimelineSemaphore(true);
+    }
+    if (bindlessInfo.supported || timelineSupported) {
+        deviceCreateInfo.setPNext(&vulkan12Features);
+    }
+
+    std::vector<std::uint32_t> families = {queueInfo.graphicsIndex.value()};
+    for (auto index : {queueInfo.presentIndex.value(), queueInfo.transferIndex.value()}) {
+        if (std::find(families.begin(), families.end(), index) == families.end()) {
+            families.push_back(index);
+        }
+    }
+
     std::vector<vk::DeviceQueueCreateInfo> queueInfos;
     float priority = 1;
-    if (queueInfo.graphicsIndex.value() == queueInfo.presentIndex.value()) {
-        vk::DeviceQueueCreateInfo queueCreateInfo;
-        queueCreateInfo.setPQueuePriorities(&priority);
-        queueCreateInfo.setQueueCount(1);
-        queueCreateInfo.setQueueFamilyIndex(queueInfo.graphicsIndex.value());
-        queueInfos.push_back(queueCreateInfo);
-    } else {
+    for (auto index : families) {
         vk::DeviceQueueCreateInfo queueCreateInfo;
         queueCreateInfo.setPQueuePriorities(&priority);
         queueCreateInfo.setQueueCount(1);
-        queueCreateInfo.setQueueFamilyIndex(queueInfo.graphicsIndex.value());
-        queueInfos.push_back(queueCreateInfo);
-
-        queueCreateInfo.setQueueFamilyIndex(queueInfo.presentIndex.value());
+        queueCreateInfo.setQueueFamilyIndex(index);
         queueInfos.push_back(queueCreateInfo);
     }
     deviceCreateInfo.setQueueCreateInfos(queueInfos);
@@ -109,7 +125,9 @@ vk::Device Context::createDevice(vk::SurfaceKHR surface) {
 void Context::queryQueueInfo(vk::SurfaceKHR surface) {
     auto queueProps = phyDevice.getQueueFamilyProperties();
     for (int i = 0; i < queueProps.size(); i++) {
-        if (queueProps[i].queueFlags & vk::QueueFlagBits::eGraphics) {
+        // sprite culling is dispatched on the graphics queue too
+        auto flags = vk::QueueFlagBits::eGraphics|vk::QueueFlagBits::eCompute;
+        if ((queueProps[i].queueFlags & flags) == flags) {
             queueInfo.graphicsIndex = i;
         }
 
@@ -122,6 +140,54 @@ void Context::queryQueueInfo(vk::SurfaceKHR surface) {
             break;
         }
     }
+
+    // a family with transfer but without graphics usually maps to the copy engine,
+    // which runs uploads alongside rendering
+    for (int i = 0; i < queueProps.size(); i++) {
+        auto flags = queueProps[i].queueFlags;
+        if ((flags & vk::QueueFlagBits::eTransfer) && !(flags & vk::QueueFlagBits::eGraphics) &&
+            !(flags & vk::QueueFlagBits::eCompute)) {
+            queueInfo.transferIndex = i;
+            break;
+        }
+    }
+    if (!queueInfo.transferIndex.has_value()) {
+        queueInfo.transferIndex = queueInfo.graphicsIndex;
+    }
+}
+
+void Context::queryBindlessInfo() {
+    // descriptor indexing is core since Vulkan 1.2
+    if (phyDevice.getProperties().apiVersion < VK_API_VERSION_1_2) {
+        return;
+    }
+
+    auto features = phyDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan12Features>();
+    auto& vulkan12Features = features.get<vk::PhysicalDeviceVulkan12Features>();
+    bindlessInfo.supported = vulkan12Features.runtimeDescriptorArray &&
+                             vulkan12Features.shaderSampledImageArrayNonUniformIndexing &&
+                             vulkan12Features.descriptorBindingPartiallyBound &&
+                             vulkan12Features.descriptorBindingSampledImageUpdateAfterBind &&
+                             vulkan12Features.descriptorBindingUpdateUnusedWhilePending;
+    if (!bindlessInfo.supported) {
+        return;
+    }
+
+    auto properties = phyDevice.getProperties2<vk::PhysicalDeviceProperties2, vk::PhysicalDeviceVulkan12Properties>();
+    auto& vulkan12Properties = properties.get<vk::PhysicalDeviceVulkan12Properties>();
+    bindlessInfo.maxTextureCount = std::min({BindlessInfo::MaxTextureCount,
+                                             vulkan12Properties.maxPerStageDescriptorUpdateAfterBindSampledImages,
+                                             vulkan12Properties.maxPerStageDescriptorUpdateAfterBindSamplers,
+                                             vulkan12Properties.maxDescriptorSetUpdateAfterBindSampledImages});
+}
+
+void Context::queryTimelineInfo() {
+    if (phyDevice.getProperties().apiVersion < VK_API_VERSION_1_2) {
+        return;
+    }
+
+    auto features = phyDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan12Features>();
+    timelineSupported = features.get<vk::PhysicalDeviceVulkan12Features>().timelineSemaphore;
 }
 
 void Context::initSwapchain(int windowWidth, int windowHeight) {
@@ -134,16 +200,37 @@ void Context::initRenderProcess() {
 
 void Context::initGraphicsPipeline() {
     renderProcess->CreateGraphicsPipeline(*shader);
+    renderProcess->CreateComputePipeline(*shader);
 }
 
 void Context::initCommandPool() {
     commandManager = std::make_unique<CommandManager>();
 }
 
+void Context::initUploadQueue() {
+    if (timelineSupported) {
+        uploadQueue = std::make_unique<UploadQueue>();
+    }
+}
+
+void Context::initStagingPool() {
+    // fits a 2048x2048 RGBA image, grows when a larger upload comes
+    stagingPool = std::make_unique<StagingPool>(16 * 1024 * 1024);
+}
+
+void Context::initDeletionQueue() {
+    deletionQueue = std::make_unique<DeletionQueue>();
+}
+
 void Context::initShaderModules() {
-    auto vertexSource = ReadWholeFile("./vert.spv");
-    auto fragSource = ReadWholeFile("./frag.spv");
-    shader = std::make_unique<Shader>(vertexSource, fragSource);
+    // modules are created straight from the mappings, which page aligns the code
+    MappedFile vertexSource("./vert.spv");
+    MappedFile spriteVertexSource("./sprite_vert.spv");
+    MappedFile fragSource("./frag.spv");
+    MappedFile bindlessFragSource("./bindless_frag.spv");
+    MappedFile cullCompSource("./cull_comp.spv");
+    shader = std::make_unique<Shader>(vertexSource.View(), spriteVertexSource.View(), fragSource.View(),
+                                      bindlessFragSource.View(), cullCompSource.View());
 }
 
 void Context::initSampler() {
@@ -157,13 +244,18 @@ void Context::initSampler() {
               .setBorderColor(vk::BorderColor::eIntOpaqueBlack)
               .setUnnormalizedCoordinates(false)
               .setCompareEnable(false)
-              .setMipmapMode(vk::SamplerMipmapMode::eLinear);
+              .setMipmapMode(vk::SamplerMipmapMode::eLinear)
+              .setMinLod(0)
+              .setMaxLod(VK_LOD_CLAMP_NONE);
     sampler = Context::Instance().device.createSampler(createInfo);
 }
 
 Context::~Context() {
+    deletionQueue.reset();
     shader.reset();
     device.destroySampler(sampler);
+    uploadQueue.reset();
+    stagingPool.reset();
     commandManager.reset();
     renderProcess.reset();
     swapchain.reset();
@@ -0,0 +1,96 @@
+#include "toy2d/cull.hpp"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define TOY2D_CULL_AVX2
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TOY2D_CULL_SSE2
+#endif
+
+namespace toy2d {
+
+void RectArrays::Push(float centerX, float centerY, float halfWidth, float halfHeight) {
+    x.push_back(centerX);
+    y.push_back(centerY);
+    halfW.push_back(halfWidth);
+    halfH.push_back(halfHeight);
+}
+
+void RectArrays::Clear() {
+    x.clear();
+    y.clear();
+    halfW.clear();
+    halfH.clear();
+}
+
+// expand a movemask result into one byte per lane
+static size_t writeMask(int mask, int lanes, uint8_t* visible) {
+    size_t count = 0;
+    for (int i = 0; i < lanes; i++) {
+        visible[i] = (mask >> i) & 1;
+        count += visible[i];
+    }
+    return count;
+}
+
+size_t CullRects(const RectArrays& rects, const ViewBounds& bounds, uint8_t* visible) {
+    const float* x = rects.x.data();
+    const float* y = rects.y.data();
+    const float* halfW = rects.halfW.data();
+    const float* halfH = rects.halfH.data();
+    size_t count = rects.Size();
+    size_t visibleCount = 0;
+    size_t i = 0;
+
+    // a rect is visible when x + halfW >= minX && x - halfW <= maxX, same for y
+
+#ifdef TOY2D_CULL_AVX2
+    __m256 minX8 = _mm256_set1_ps(bounds.minX);
+    __m256 minY8 = _mm256_set1_ps(bounds.minY);
+    __m256 maxX8 = _mm256_set1_ps(bounds.maxX);
+    __m256 maxY8 = _mm256_set1_ps(bounds.maxY);
+    for (; i + 8 <= count; i += 8) {
+        __m256 cx = _mm256_loadu_ps(x + i);
+        __m256 cy = _mm256_loadu_ps(y + i);
+        __m256 hw = _mm256_loadu_ps(halfW + i);
+        __m256 hh = _mm256_loadu_ps(halfH + i);
+        __m256 inX = _mm256_and_ps(_mm256_cmp_ps(_mm256_add_ps(cx, hw), minX8, _CMP_GE_OQ),
+                                   _mm256_cmp_ps(_mm256_sub_ps(cx, hw), maxX8, _CMP_LE_OQ));
+        __m256 inY = _mm256_and_ps(_mm256_cmp_ps(_mm256_add_ps(cy, hh), minY8, _CMP_GE_OQ),
+                                   _mm256_cmp_ps(_mm256_sub_ps(cy, hh), maxY8, _CMP_LE_OQ));
+        visibleCount += writeMask(_mm256_movemask_ps(_mm256_and_ps(inX, inY)), 8, visible + i);
+    }
+#endif
+
+#ifdef TOY2D_CULL_SSE2
+    __m128 minX4 = _mm_set1_ps(bounds.minX);
+    __m128 minY4 = _mm_set1_ps(bounds.minY);
+    __m128 maxX4 = _mm_set1_ps(bounds.maxX);
+    __m128 maxY4 = _mm_set1_ps(bounds.maxY);
+    for (; i + 4 <= count; i += 4) {
+        __m128 cx = _mm_loadu_ps(x + i);
+        __m128 cy = _mm_loadu_ps(y + i);
+        __m128 hw = _mm_loadu_ps(halfW + i);
+        __m128 hh = _mm_loadu_ps(halfH + i);
+        __m128 inX = _mm_and_ps(_mm_cmpge_ps(_mm_add_ps(cx, hw), minX4),
+                                _mm_cmple_ps(_mm_sub_ps(cx, hw), maxX4));
+        __m128 inY = _mm_and_ps(_mm_cmpge_ps(_mm_add_ps(cy, hh), minY4),
+                                _mm_cmple_ps(_mm_sub_ps(cy, hh), maxY4));
+        visibleCount += writeMask(_mm_movemask_ps(_mm_and_ps(inX, inY)), 4, visible + i);
+    }
+#endif
+
+    for (; i < count; i++) {
+        bool in = x[i] + halfW[i] >= bounds.minX && x[i] - halfW[i] <= bounds.maxX &&
+                  y[i] + halfH[i] >= bounds.minY && y[i] - halfH[i] <= bounds.maxY;
+        visible[i] = in;
+        visibleCount += in;
+    }
+
+    return visibleCount;
+}
+
+}
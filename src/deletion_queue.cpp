@@ -0,0 +1,61 @@
+#include "toy2d/deletion_queue.hpp"
+#include "toy2d/context.hpp"
+#include <cassert>
+
+namespace toy2d {
+
+DeletionQueue::~DeletionQueue() {
+    // a release running now would reach objects torn down before the context
+    assert(entries_.empty() && "resources retired after the deletion queue was flushed");
+}
+
+void DeletionQueue::Push(Release release, uint64_t uploadValue) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.push_back({frame_, uploadValue, std::move(release)});
+}
+
+void DeletionQueue::BeginFrame(uint64_t frame) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    frame_ = frame;
+}
+
+void DeletionQueue::Collect(uint64_t completedFrame) {
+    auto& uploads = Context::Instance().uploadQueue;
+    std::vector<Release> ready;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // entries are in frame order, only the front can be ready
+        size_t kept = 0;
+        size_t i = 0;
+        for (; i < entries_.size() && entries_[i].frame <= completedFrame; i++) {
+            auto& entry = entries_[i];
+            if (entry.uploadValue != 0 && uploads && !uploads->IsComplete(entry.uploadValue)) {
+                entries_[kept++] = std::move(entry);
+            } else {
+                ready.push_back(std::move(entry.release));
+            }
+        }
+        for (; i < entries_.size(); i++) {
+            entries_[kept++] = std::move(entries_[i]);
+        }
+        entries_.resize(kept);
+    }
+
+    // outside the lock, a release may retire more resources
+    for (auto& release : ready) {
+        release();
+    }
+}
+
+void DeletionQueue::Flush() {
+    std::vector<Entry> entries;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries.swap(entries_);
+    }
+    for (auto& entry : entries) {
+        entry.release();
+    }
+}
+
+}
@@ -15,18 +15,28 @@ DescriptorSetManager::DescriptorSetManager(uint32_t maxFlight): maxFlight_(maxFl
     auto pool = Context::Instance().device.createDescriptorPool(createInfo);
     bufferSetPool_.pool_ = pool;
     bufferSetPool_.remainNum_ = maxFlight;
+
+    if (Context::Instance().bindlessInfo.supported) {
+        createTextureTable();
+    }
 }
 
 DescriptorSetManager::~DescriptorSetManager() {
     auto& device = Context::Instance().device;
 
     device.destroyDescriptorPool(bufferSetPool_.pool_);
+    if (textureTable_.pool) {
+        device.destroyDescriptorPool(textureTable_.pool);
+    }
     for (auto pool : fulledImageSetPool_) {
         device.destroyDescriptorPool(pool.pool_);
     }
     for (auto pool : avalibleImageSetPool_) {
         device.destroyDescriptorPool(pool.pool_);
     }
+    for (auto pool : cullSetPools_) {
+        device.destroyDescriptorPool(pool.pool_);
+    }
 }
 
 void DescriptorSetManager::addImageSetPool() {
@@ -105,6 +115,103 @@ void DescriptorSetManager::FreeImageSet(const SetInfo& info) {
     }
 }
 
+DescriptorSetManager::SetInfo DescriptorSetManager::AllocCullSet() {
+    constexpr uint32_t MaxSetNum = 16;
+    constexpr uint32_t BufferNumPerSet = 3;
+
+    auto& device = Context::Instance().device;
+    auto it = std::find_if(cullSetPools_.begin(), cullSetPools_.end(),
+                           [](const PoolInfo& poolInfo) {
+                                return poolInfo.remainNum_ > 0;
+                           });
+    if (it == cullSetPools_.end()) {
+        vk::DescriptorPoolSize size;
+        size.setType(vk::DescriptorType::eStorageBuffer)
+            .setDescriptorCount(MaxSetNum * BufferNumPerSet);
+        vk::DescriptorPoolCreateInfo createInfo;
+        createInfo.setMaxSets(MaxSetNum)
+                  .setPoolSizes(size)
+                  .setFlags(vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet);
+        cullSetPools_.push_back({device.createDescriptorPool(createInfo), MaxSetNum});
+        it = cullSetPools_.end() - 1;
+    }
+
+    std::vector<vk::DescriptorSetLayout> layouts{ Context::Instance().shader->GetCullDescriptorSetLayout() };
+    vk::DescriptorSetAllocateInfo allocInfo;
+    allocInfo.setDescriptorPool(it->pool_)
+             .setDescriptorSetCount(1)
+             .setSetLayouts(layouts);
+
+    SetInfo result;
+    result.pool = it->pool_;
+    result.set = device.allocateDescriptorSets(allocInfo)[0];
+    it->remainNum_ --;
+    return result;
+}
+
+void DescriptorSetManager::FreeCullSet(const SetInfo& info) {
+    auto it = std::find_if(cullSetPools_.begin(), cullSetPools_.end(),
+                           [&](const PoolInfo& poolInfo) {
+                                return poolInfo.pool_ == info.pool;
+                           });
+    if (it != cullSetPools_.end()) {
+        Context::Instance().device.freeDescriptorSets(info.pool, info.set);
+        it->remainNum_ ++;
+    }
+}
+
+void DescriptorSetManager::createTextureTable() {
+    auto& ctx = Context::Instance();
+
+    vk::DescriptorPoolSize size;
+    size.setType(vk::DescriptorType::eCombinedImageSampler)
+        .setDescriptorCount(ctx.bindlessInfo.maxTextureCount);
+    vk::DescriptorPoolCreateInfo createInfo;
+    createInfo.setMaxSets(1)
+              .setPoolSizes(size)
+              .setFlags(vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind);
+    textureTable_.pool = ctx.device.createDescriptorPool(createInfo);
+
+    std::vector<vk::DescriptorSetLayout> layouts{ ctx.shader->GetDescriptorSetLayouts()[2] };
+    vk::DescriptorSetAllocateInfo allocInfo;
+    allocInfo.setDescriptorPool(textureTable_.pool)
+             .setDescriptorSetCount(1)
+             .setSetLayouts(layouts);
+    textureTable_.set = ctx.device.allocateDescriptorSets(allocInfo)[0];
+}
+
+uint32_t DescriptorSetManager::AllocTextureIndex(vk::ImageView view, vk::Sampler sampler) {
+    uint32_t index;
+    if (!freeTextureIndices_.empty()) {
+        index = freeTextureIndices_.back();
+        freeTextureIndices_.pop_back();
+    } else if (nextTextureIndex_ < Context::Instance().bindlessInfo.maxTextureCount) {
+        index = nextTextureIndex_++;
+    } else {
+        throw std::runtime_error("bindless texture table is full");
+    }
+
+    vk::DescriptorImageInfo imageInfo;
+    imageInfo.setImageLayout(vk::ImageLayout::eShaderReadOnlyOptimal)
+             .setImageView(view)
+             .setSampler(sampler);
+    vk::WriteDescriptorSet writer;
+    writer.setImageInfo(imageInfo)
+          .setDstBinding(0)
+          .setDstArrayElement(index)
+          .setDstSet(textureTable_.set)
+          .setDescriptorCount(1)
+          .setDescriptorType(vk::DescriptorType::eCombinedImageSampler);
+    Context::Instance().device.updateDescriptorSets(writer, {});
+
+    return index;
+}
+
+void DescriptorSetManager::FreeTextureIndex(uint32_t index) {
+    // the slot is partially bound, it may stay stale until it is reused
+    freeTextureIndices_.push_back(index);
+}
+
 DescriptorSetManager::PoolInfo& DescriptorSetManager::getAvaliableImagePoolInfo() {
     if (avalibleImageSetPool_.empty()) {
         addImageSetPool();
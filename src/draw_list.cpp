@@ -0,0 +1,84 @@
+#include "toy2d/draw_list.hpp"
+#include <algorithm>
+
+namespace toy2d {
+
+void DrawList::SetDepth(float depth) {
+    depth_ = static_cast<uint32_t>(std::clamp(depth, 0.0f, 1.0f) * 0xFFFFF);
+}
+
+uint64_t DrawList::makeKey(Pipeline pipeline, uint32_t textureId) const {
+    return (static_cast<uint64_t>(layer_) << 48) |
+           (static_cast<uint64_t>(pipeline) << 44) |
+           (static_cast<uint64_t>(textureId & 0xFFFFFF) << 20) |
+           static_cast<uint64_t>(depth_ & 0xFFFFF);
+}
+
+void DrawList::AddSprite(const SpriteInstance& instance, Texture& texture) {
+    packets_.push_back({makeKey(Pipeline::Sprite, texture.id), static_cast<uint32_t>(sprites_.size())});
+    sprites_.push_back({instance, &texture});
+}
+
+void DrawList::AddLine(const Vertex& p1, const Vertex& p2) {
+    packets_.push_back({makeKey(Pipeline::Line, 0), static_cast<uint32_t>(lines_.size())});
+    lines_.push_back({p1, p2});
+}
+
+void DrawList::AddIndirect(const IndirectData& indirect) {
+    uint32_t textureId = indirect.texture ? indirect.texture->id : 0;
+    packets_.push_back({makeKey(Pipeline::SpriteBuffer, textureId), static_cast<uint32_t>(indirects_.size())});
+    indirects_.push_back(indirect);
+}
+
+void DrawList::AddScene(const SpriteScene& scene) {
+    packets_.push_back({makeKey(Pipeline::SpriteScene, 0), static_cast<uint32_t>(scenes_.size())});
+    scenes_.push_back(&scene);
+}
+
+void DrawList::DrawTexture(const Rect& rect, Texture& texture) {
+    if (!texture.IsReady()) {
+        return;
+    }
+    AddSprite(SpriteInstance{rect.position, rect.size, texture.uv, color_.Pack(), texture.bindlessIndex}, texture);
+}
+
+void DrawList::DrawLine(const Vec& p1, const Vec& p2) {
+    AddLine(Vertex{p1, Vec{0, 0}, color_}, Vertex{p2, Vec{0, 0}, color_});
+}
+
+void DrawList::Sort() {
+    // LSD radix sort, 8 bits per pass. Passes where every key has the same
+    // byte are skipped, usually most of them as few layers and textures are used.
+    sortBuffer_.resize(packets_.size());
+    for (int shift = 0; shift < 64; shift += 8) {
+        size_t counts[256] = {0};
+        for (auto& packet : packets_) {
+            counts[(packet.key >> shift) & 0xFF] ++;
+        }
+        if (std::any_of(std::begin(counts), std::end(counts),
+                        [&](size_t count) { return count == packets_.size(); })) {
+            continue;
+        }
+
+        size_t offset = 0;
+        for (auto& count : counts) {
+            size_t c = count;
+            count = offset;
+            offset += c;
+        }
+        for (auto& packet : packets_) {
+            sortBuffer_[counts[(packet.key >> shift) & 0xFF] ++] = packet;
+        }
+        packets_.swap(sortBuffer_);
+    }
+}
+
+void DrawList::Clear() {
+    packets_.clear();
+    sprites_.clear();
+    lines_.clear();
+    indirects_.clear();
+    scenes_.clear();
+}
+
+}
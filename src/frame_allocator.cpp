@@ -0,0 +1,50 @@
+#include "toy2d/frame_allocator.hpp"
+
+namespace toy2d {
+
+constexpr vk::BufferUsageFlags FrameBufferUsage = vk::BufferUsageFlagBits::eVertexBuffer|
+                                                  vk::BufferUsageFlagBits::eIndexBuffer|
+                                                  vk::BufferUsageFlagBits::eUniformBuffer|
+                                                  vk::BufferUsageFlagBits::eStorageBuffer|
+                                                  vk::BufferUsageFlagBits::eTransferSrc;
+
+FrameAllocator::FrameAllocator(size_t size) {
+    buffer_.reset(new Buffer(FrameBufferUsage,
+                             size,
+                             vk::MemoryPropertyFlagBits::eHostVisible|vk::MemoryPropertyFlagBits::eHostCoherent));
+}
+
+FrameAllocator::Allocation FrameAllocator::Allocate(size_t size, size_t alignment) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t offset = (offset_ + alignment - 1) / alignment * alignment;
+    if (offset + size > buffer_->size) {
+        grow(size);
+        offset = 0;
+    }
+
+    offset_ = offset + size;
+
+    Allocation allocation;
+    allocation.buffer = buffer_->buffer;
+    allocation.offset = offset;
+    allocation.map = (char*)buffer_->map + offset;
+    return allocation;
+}
+
+void FrameAllocator::Reset() {
+    retiredBuffers_.clear();
+    offset_ = 0;
+}
+
+void FrameAllocator::grow(size_t minSize) {
+    // commands recorded earlier in this frame still read the old buffer,
+    // so it is only released in Reset(). The new one keeps its size for
+    // later frames, after a few frames no more growth happens.
+    size_t newSize = std::max(buffer_->size * 2, minSize);
+    retiredBuffers_.push_back(std::move(buffer_));
+    buffer_.reset(new Buffer(FrameBufferUsage,
+                             newSize,
+                             vk::MemoryPropertyFlagBits::eHostVisible|vk::MemoryPropertyFlagBits::eHostCoherent));
+}
+
+}
@@ -0,0 +1,103 @@
+#include "toy2d/image_cache.hpp"
+#include "toy2d/asset_archive.hpp"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+namespace toy2d {
+
+ImageDiskCache::ImageDiskCache(const std::string& directory): directory_(directory) {
+    std::error_code error;
+    std::filesystem::create_directories(directory_, error);
+}
+
+bool ImageDiskCache::entryPath(const std::string& filename, std::string& path, uint64_t& size, int64_t& time) const {
+    std::error_code error;
+    auto source = std::filesystem::canonical(filename, error);
+    if (error) {
+        return false;
+    }
+    size = std::filesystem::file_size(source, error);
+    if (error) {
+        return false;
+    }
+    time = std::filesystem::last_write_time(source, error).time_since_epoch().count();
+    if (error) {
+        return false;
+    }
+
+    std::ostringstream key;
+    key << source.string() << '|' << size << '|' << time;
+    std::ostringstream name;
+    name << std::hex << std::setw(16) << std::setfill('0') << HashAssetName(key.str()) << ".t2i";
+    path = (std::filesystem::path(directory_) / name.str()).string();
+    return true;
+}
+
+ImageDiskCache::Entry ImageDiskCache::Find(const std::string& filename) const {
+    Entry entry;
+    std::string path;
+    uint64_t size;
+    int64_t time;
+    std::error_code error;
+    if (!entryPath(filename, path, size, time) || !std::filesystem::exists(path, error)) {
+        return entry;
+    }
+
+    MappedFile file(path, MappedFile::Access::Sequential);
+    if (file.Size() < sizeof(ImageCacheHeader)) {
+        return entry;
+    }
+    auto header = reinterpret_cast<const ImageCacheHeader*>(file.Data());
+    // the hash in the name could collide, the header has the last word
+    if (memcmp(header->magic, ImageCacheMagic, sizeof(ImageCacheMagic)) != 0 ||
+        header->version != ImageCacheVersion ||
+        header->sourceSize != size || header->sourceTime != time ||
+        file.Size() != sizeof(ImageCacheHeader) + uint64_t(header->width) * header->height * 4) {
+        return entry;
+    }
+
+    entry.width = header->width;
+    entry.height = header->height;
+    entry.file = std::move(file);
+    return entry;
+}
+
+void ImageDiskCache::Store(const std::string& filename, const void* pixels, uint32_t w, uint32_t h) const {
+    std::string path;
+    ImageCacheHeader header;
+    if (!entryPath(filename, path, header.sourceSize, header.sourceTime)) {
+        return;
+    }
+    memcpy(header.magic, ImageCacheMagic, sizeof(ImageCacheMagic));
+    header.version = ImageCacheVersion;
+    header.width = w;
+    header.height = h;
+
+    // written under a name of its own and renamed, so readers never map half an entry
+    std::ostringstream tmpPath;
+    tmpPath << path << '.' << std::hash<std::thread::id>()(std::this_thread::get_id()) << ".tmp";
+    {
+        std::ofstream file(tmpPath.str(), std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(static_cast<const char*>(pixels), static_cast<std::streamsize>(w) * h * 4);
+        if (!file) {
+            file.close();
+            std::error_code error;
+            std::filesystem::remove(tmpPath.str(), error);
+            return;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tmpPath.str(), path, error);
+    if (error) {
+        std::filesystem::remove(tmpPath.str(), error);
+    }
+}
+
+}
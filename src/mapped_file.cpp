@@ -0,0 +1,125 @@
+#include "toy2d/mapped_file.hpp"
+#include <iostream>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace toy2d {
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string& filename, Access) {
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    LARGE_INTEGER size;
+    if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        if (file != INVALID_HANDLE_VALUE) {
+            CloseHandle(file);
+        }
+        std::cout << "map " << filename << " failed" << std::endl;
+        return;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    void* data = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (!data) {
+        if (mapping) {
+            CloseHandle(mapping);
+        }
+        CloseHandle(file);
+        std::cout << "map " << filename << " failed" << std::endl;
+        return;
+    }
+
+    file_ = file;
+    mapping_ = mapping;
+    data_ = static_cast<const char*>(data);
+    size_ = static_cast<size_t>(size.QuadPart);
+}
+
+void MappedFile::close() {
+    if (data_) {
+        UnmapViewOfFile(data_);
+        CloseHandle(mapping_);
+        CloseHandle(file_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+    file_ = nullptr;
+    mapping_ = nullptr;
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& filename, Access access) {
+    int fd = open(filename.c_str(), O_RDONLY);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0 || info.st_size == 0) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        std::cout << "map " << filename << " failed" << std::endl;
+        return;
+    }
+
+    void* data = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // the mapping keeps the file alive
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        std::cout << "map " << filename << " failed" << std::endl;
+        return;
+    }
+
+    // start reading ahead now, decoders touch the pages right after mapping
+    if (access == Access::Sequential) {
+        madvise(data, info.st_size, MADV_WILLNEED);
+        madvise(data, info.st_size, MADV_SEQUENTIAL);
+    } else {
+        madvise(data, info.st_size, MADV_RANDOM);
+    }
+
+    data_ = static_cast<const char*>(data);
+    size_ = static_cast<size_t>(info.st_size);
+}
+
+void MappedFile::close() {
+    if (data_) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+    data_ = nullptr;
+    size_ = 0;
+}
+
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        std::swap(data_, other.data_);
+        std::swap(size_, other.size_);
+#ifdef _WIN32
+        std::swap(file_, other.file_);
+        std::swap(mapping_, other.mapping_);
+#endif
+    }
+    return *this;
+}
+
+}
@@ -3,7 +3,7 @@
 namespace toy2d {
 
 std::vector<vk::VertexInputAttributeDescription> Vec::GetAttributeDescription() {
-    std::vector<vk::VertexInputAttributeDescription> descriptions(2);
+    std::vector<vk::VertexInputAttributeDescription> descriptions(3);
     descriptions[0].setBinding(0)
                    .setFormat(vk::Format::eR32G32Sfloat)
                    .setLocation(0)
@@ -12,6 +12,10 @@ std::vector<vk::VertexInputAttributeDescription> Vec::GetAttributeDescription()
                    .setFormat(vk::Format::eR32G32Sfloat)
                    .setLocation(1)
                    .setOffset(offsetof(Vertex, texcoord));
+    descriptions[2].setBinding(0)
+                   .setFormat(vk::Format::eR32G32B32Sfloat)
+                   .setLocation(2)
+                   .setOffset(offsetof(Vertex, color));
     return descriptions;
 }
 
@@ -23,6 +27,58 @@ std::vector<vk::VertexInputBindingDescription> Vec::GetBindingDescription() {
     return descriptions;
 }
 
+std::vector<vk::VertexInputAttributeDescription> SpriteInstance::GetAttributeDescription() {
+    // binding 0 is the unit quad, only position and texcoord of it are used
+    std::vector<vk::VertexInputAttributeDescription> descriptions(7);
+    descriptions[0].setBinding(0)
+                   .setFormat(vk::Format::eR32G32Sfloat)
+                   .setLocation(0)
+                   .setOffset(0);
+    descriptions[1].setBinding(0)
+                   .setFormat(vk::Format::eR32G32Sfloat)
+                   .setLocation(1)
+                   .setOffset(offsetof(Vertex, texcoord));
+    descriptions[2].setBinding(1)
+                   .setFormat(vk::Format::eR32G32Sfloat)
+                   .setLocation(2)
+                   .setOffset(offsetof(SpriteInstance, position));
+    descriptions[3].setBinding(1)
+                   .setFormat(vk::Format::eR32G32Sfloat)
+                   .setLocation(3)
+                   .setOffset(offsetof(SpriteInstance, size));
+    descriptions[4].setBinding(1)
+                   .setFormat(vk::Format::eR32G32B32A32Sfloat)
+                   .setLocation(4)
+                   .setOffset(offsetof(SpriteInstance, uv));
+    descriptions[5].setBinding(1)
+                   .setFormat(vk::Format::eR8G8B8A8Unorm)
+                   .setLocation(5)
+                   .setOffset(offsetof(SpriteInstance, color));
+    descriptions[6].setBinding(1)
+                   .setFormat(vk::Format::eR32Uint)
+                   .setLocation(6)
+                   .setOffset(offsetof(SpriteInstance, texture));
+    return descriptions;
+}
+
+std::vector<vk::VertexInputBindingDescription> SpriteInstance::GetBindingDescription() {
+    std::vector<vk::VertexInputBindingDescription> descriptions(2);
+    descriptions[0].setBinding(0)
+                   .setStride(sizeof(Vertex))
+                   .setInputRate(vk::VertexInputRate::eVertex);
+    descriptions[1].setBinding(1)
+                   .setStride(sizeof(SpriteInstance))
+                   .setInputRate(vk::VertexInputRate::eInstance);
+    return descriptions;
+}
+
+uint32_t Color::Pack() const {
+    auto toByte = [](float value) {
+        return static_cast<uint32_t>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+    };
+    return toByte(r) | (toByte(g) << 8) | (toByte(b) << 16) | (0xFFu << 24);
+}
+
 Mat4 Mat4::Create(const std::initializer_list<float>& initList) {
     Mat4 mat;
     int counter = 0;
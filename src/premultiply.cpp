@@ -0,0 +1,75 @@
+#include "toy2d/premultiply.hpp"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define TOY2D_PREMULTIPLY_AVX2
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TOY2D_PREMULTIPLY_SSE2
+#endif
+
+namespace toy2d {
+
+// exact c * a / 255 for 8 bit c and a: t = c * a + 128, (t + (t >> 8)) >> 8
+static uint8_t mulDiv255(uint32_t c, uint32_t a) {
+    uint32_t t = c * a + 128;
+    return static_cast<uint8_t>((t + (t >> 8)) >> 8);
+}
+
+void PremultiplyAlpha(uint8_t* pixels, size_t pixelCount) {
+    size_t i = 0;
+
+    // pixels are widened to 16 bit lanes, two per 128 bits. Each lane is multiplied with
+    // the alpha of its pixel, alpha lanes with 255 so they keep their value
+
+#ifdef TOY2D_PREMULTIPLY_AVX2
+    const __m256i zero8 = _mm256_setzero_si256();
+    const __m256i colorMask8 = _mm256_set1_epi64x(0x0000FFFFFFFFFFFFll);
+    const __m256i alphaOne8 = _mm256_set1_epi64x(0x00FF000000000000ll);
+    const __m256i round8 = _mm256_set1_epi16(128);
+    auto premultiply8 = [&](__m256i c) {
+        __m256i a = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(c, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+        a = _mm256_or_si256(_mm256_and_si256(a, colorMask8), alphaOne8);
+        __m256i t = _mm256_add_epi16(_mm256_mullo_epi16(c, a), round8);
+        return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+    };
+    for (; i + 8 <= pixelCount; i += 8) {
+        __m256i* p = reinterpret_cast<__m256i*>(pixels + i * 4);
+        __m256i c = _mm256_loadu_si256(p);
+        __m256i lo = premultiply8(_mm256_unpacklo_epi8(c, zero8));
+        __m256i hi = premultiply8(_mm256_unpackhi_epi8(c, zero8));
+        _mm256_storeu_si256(p, _mm256_packus_epi16(lo, hi));
+    }
+#endif
+
+#ifdef TOY2D_PREMULTIPLY_SSE2
+    const __m128i zero4 = _mm_setzero_si128();
+    const __m128i colorMask4 = _mm_set_epi32(0x0000FFFF, 0xFFFFFFFF, 0x0000FFFF, 0xFFFFFFFF);
+    const __m128i alphaOne4 = _mm_set_epi32(0x00FF0000, 0, 0x00FF0000, 0);
+    const __m128i round4 = _mm_set1_epi16(128);
+    auto premultiply4 = [&](__m128i c) {
+        __m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(c, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+        a = _mm_or_si128(_mm_and_si128(a, colorMask4), alphaOne4);
+        __m128i t = _mm_add_epi16(_mm_mullo_epi16(c, a), round4);
+        return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+    };
+    for (; i + 4 <= pixelCount; i += 4) {
+        __m128i* p = reinterpret_cast<__m128i*>(pixels + i * 4);
+        __m128i c = _mm_loadu_si128(p);
+        __m128i lo = premultiply4(_mm_unpacklo_epi8(c, zero4));
+        __m128i hi = premultiply4(_mm_unpackhi_epi8(c, zero4));
+        _mm_storeu_si128(p, _mm_packus_epi16(lo, hi));
+    }
+#endif
+
+    for (; i < pixelCount; i++) {
+        uint8_t* p = pixels + i * 4;
+        p[0] = mulDiv255(p[0], p[3]);
+        p[1] = mulDiv255(p[1], p[3]);
+        p[2] = mulDiv255(p[2], p[3]);
+    }
+}
+
+}
@@ -19,11 +19,57 @@ RenderProcess::~RenderProcess() {
     device.destroyPipelineLayout(layout);
     device.destroyPipeline(graphicsPipelineWithTriangleTopology);
     device.destroyPipeline(graphicsPipelineWithLineTopology);
+    if (graphicsPipelineWithBindlessTexture) {
+        device.destroyPipeline(graphicsPipelineWithBindlessTexture);
+    }
+    device.destroyPipeline(computePipelineWithCulling);
+    device.destroyPipelineLayout(cullLayout);
 }
 
 void RenderProcess::CreateGraphicsPipeline(const Shader& shader) {
-    graphicsPipelineWithTriangleTopology = createGraphicsPipeline(shader, vk::PrimitiveTopology::eTriangleList);
-    graphicsPipelineWithLineTopology = createGraphicsPipeline(shader, vk::PrimitiveTopology::eLineList);
+    // triangles are only used for instanced sprites on the unit quad
+    graphicsPipelineWithTriangleTopology = createGraphicsPipeline(shader.GetSpriteVertexModule(),
+                                                                  shader.GetFragModule(),
+                                                                  vk::PrimitiveTopology::eTriangleList,
+                                                                  SpriteInstance::GetAttributeDescription(),
+                                                                  SpriteInstance::GetBindingDescription());
+    graphicsPipelineWithLineTopology = createGraphicsPipeline(shader.GetVertexModule(),
+                                                              shader.GetFragModule(),
+                                                              vk::PrimitiveTopology::eLineList,
+                                                              Vec::GetAttributeDescription(),
+                                                              Vec::GetBindingDescription());
+    if (Context::Instance().bindlessInfo.supported) {
+        graphicsPipelineWithBindlessTexture = createGraphicsPipeline(shader.GetSpriteVertexModule(),
+                                                                     shader.GetBindlessFragModule(),
+                                                                     vk::PrimitiveTopology::eTriangleList,
+                                                                     SpriteInstance::GetAttributeDescription(),
+                                                                     SpriteInstance::GetBindingDescription());
+    }
+}
+
+void RenderProcess::CreateComputePipeline(const Shader& shader) {
+    auto& device = Context::Instance().device;
+
+    vk::PipelineLayoutCreateInfo layoutCreateInfo;
+    auto range = shader.GetCullPushConstantRange();
+    auto setLayout = shader.GetCullDescriptorSetLayout();
+    layoutCreateInfo.setSetLayouts(setLayout)
+                    .setPushConstantRanges(range);
+    cullLayout = device.createPipelineLayout(layoutCreateInfo);
+
+    vk::PipelineShaderStageCreateInfo stageCreateInfo;
+    stageCreateInfo.setModule(shader.GetCullCompModule())
+                   .setPName("main")
+                   .setStage(vk::ShaderStageFlagBits::eCompute);
+    vk::ComputePipelineCreateInfo createInfo;
+    createInfo.setStage(stageCreateInfo)
+              .setLayout(cullLayout);
+
+    auto result = device.createComputePipeline(pipelineCache_, createInfo);
+    if (result.result != vk::Result::eSuccess) {
+        std::cout << "create compute pipeline failed: " << result.result << std::endl;
+    }
+    computePipelineWithCulling = result.value;
 }
 
 void RenderProcess::CreateRenderPass() {
@@ -39,24 +85,26 @@ vk::PipelineLayout RenderProcess::createLayout() {
     return Context::Instance().device.createPipelineLayout(createInfo);
 }
 
-vk::Pipeline RenderProcess::createGraphicsPipeline(const Shader& shader, vk::PrimitiveTopology topology) {
+vk::Pipeline RenderProcess::createGraphicsPipeline(vk::ShaderModule vertexModule,
+                                                   vk::ShaderModule fragModule,
+                                                   vk::PrimitiveTopology topology,
+                                                   const std::vector<vk::VertexInputAttributeDescription>& attributeDesc,
+                                                   const std::vector<vk::VertexInputBindingDescription>& bindingDesc) {
     auto& ctx = Context::Instance();
 
     vk::GraphicsPipelineCreateInfo createInfo;
 
     // 0. shader prepare
     std::array<vk::PipelineShaderStageCreateInfo, 2> stageCreateInfos;
-    stageCreateInfos[0].setModule(shader.GetVertexModule())
+    stageCreateInfos[0].setModule(vertexModule)
                        .setPName("main")
                        .setStage(vk::ShaderStageFlagBits::eVertex);
-    stageCreateInfos[1].setModule(shader.GetFragModule())
+    stageCreateInfos[1].setModule(fragModule)
                        .setPName("main")
                        .setStage(vk::ShaderStageFlagBits::eFragment);
 
     // 1. vertex input
     vk::PipelineVertexInputStateCreateInfo vertexInputCreateInfo;
-    auto attributeDesc = Vec::GetAttributeDescription();
-    auto bindingDesc = Vec::GetBindingDescription();
     vertexInputCreateInfo.setVertexAttributeDescriptions(attributeDesc)
                          .setVertexBindingDescriptions(bindingDesc);
 
@@ -16,11 +16,15 @@ Renderer::Renderer(int maxFlightCount): maxFlightCount_(maxFlightCount), curFram
     createWhiteTexture();
 
     SetDrawColor(Color{1, 1, 1});
+    SetBindless(true);
 }
 
 Renderer::~Renderer() {
     auto& device = Context::Instance().device;
     device.destroySampler(sampler);
+    workerPool_.reset();
+    recorders_.clear();
+    frameAllocators_.clear();
     rectVerticesBuffer_.reset();
     rectIndicesBuffer_.reset();
     uniformBuffers_.clear();
@@ -42,6 +46,24 @@ void Renderer::StartRender() {
         throw std::runtime_error("wait for fence failed");
     }
     device.resetFences(fences_[curFrame_]);
+    // the GPU is done with this frame, its transient data can be overwritten
+    frameAllocators_[curFrame_]->Reset();
+    bufferMVPData();
+    inFrame_ = true;
+
+    // textures loaded since the last frame start uploading now
+    if (ctx.uploadQueue) {
+        ctx.uploadQueue->Submit();
+        ctx.uploadQueue->Collect();
+    }
+
+    // this frame's fence covers every frame submitted up to its last use of the slot,
+    // what they retired can be released
+    frameNumber_++;
+    ctx.deletionQueue->BeginFrame(frameNumber_);
+    if (frameNumber_ > static_cast<uint64_t>(maxFlightCount_)) {
+        ctx.deletionQueue->Collect(frameNumber_ - maxFlightCount_);
+    }
 
     auto& swapchain = ctx.swapchain;
     auto resultValue = device.acquireNextImageKHR(swapchain->swapchain, std::numeric_limits<std::uint64_t>::max(), imageAvaliableSems_[curFrame_], nullptr);
@@ -50,13 +72,33 @@ void Renderer::StartRender() {
     }
     imageIndex_ = resultValue.value;
 
-    auto& cmdMgr = ctx.commandManager;
     auto& cmd = cmdBufs_[curFrame_];
     cmd.reset();
 
     vk::CommandBufferBeginInfo beginInfo;
     beginInfo.setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
     cmd.begin(beginInfo);
+
+    auto& prepassCmd = prepassCmdBufs_[curFrame_];
+    prepassCmd.reset();
+    prepassCmd.begin(beginInfo);
+    prepassUsed_ = false;
+
+    if (workerPool_) {
+        // the secondary buffers of this frame aren't in use anymore either
+        for (auto& recorder : recorders_[curFrame_]) {
+            recorder.cmdMgr->ResetCmds();
+            recorder.usedCount = 0;
+        }
+    } else {
+        beginRenderPass(vk::SubpassContents::eInline);
+        batcher_.Begin(cmd, getFrameResources());
+    }
+}
+
+void Renderer::beginRenderPass(vk::SubpassContents contents) {
+    auto& ctx = Context::Instance();
+    auto& swapchain = ctx.swapchain;
     vk::ClearValue clearValue;
     clearValue.setColor(vk::ClearColorValue(std::array<float, 4>{0.1, 0.1, 0.1, 1}));
     vk::RenderPassBeginInfo renderPassBegin;
@@ -64,65 +106,257 @@ void Renderer::StartRender() {
                    .setFramebuffer(swapchain->framebuffers[imageIndex_])
                    .setClearValues(clearValue)
                    .setRenderArea(vk::Rect2D({}, swapchain->GetExtent()));
-    cmd.beginRenderPass(&renderPassBegin, vk::SubpassContents::eInline);
+    cmdBufs_[curFrame_].beginRenderPass(&renderPassBegin, contents);
+}
+
+Batcher::FrameResources Renderer::getFrameResources() {
+    Batcher::FrameResources resources;
+    resources.allocator = frameAllocators_[curFrame_].get();
+    resources.uniformSet = descriptorSets_[curFrame_].set;
+    resources.rectVertices = rectVerticesBuffer_.get();
+    resources.rectIndices = rectIndicesBuffer_.get();
+    resources.whiteTexture = whiteTexture;
+    resources.bindless = bindless_;
+    resources.culling = culling_;
+    resources.bounds = viewBounds_;
+    return resources;
 }
 
 void Renderer::DrawTexture(const Rect& rect, Texture& texture) {
+    if (!texture.IsReady()) {
+        return;
+    }
+    // rect.position is the quad center, the unit quad spans [-0.5, 0.5]
+    SpriteInstance instance{rect.position, rect.size, texture.uv, drawColor_.Pack(), texture.bindlessIndex};
+    if (deferred_ || workerPool_) {
+        drawList_.AddSprite(instance, texture);
+    } else {
+        batcher_.AddSprite(instance, texture);
+    }
+}
+
+void Renderer::DrawLine(const Vec& p1, const Vec& p2) {
+    Vertex v1{p1, Vec{0, 0}, drawColor_};
+    Vertex v2{p2, Vec{0, 0}, drawColor_};
+    if (deferred_ || workerPool_) {
+        drawList_.AddLine(v1, v2);
+    } else {
+        batcher_.AddLine(v1, v2);
+    }
+}
+
+void Renderer::DrawSpriteBuffer(SpriteBuffer& sprites, Texture* texture) {
+    if (!bindless_ && !texture) {
+        throw std::runtime_error("sprite buffer needs a texture when bindless textures are off");
+    }
+    if (sprites.GetCount() == 0) {
+        return;
+    }
+
+    sprites.recordUpload(prepassCmdBufs_[curFrame_], *frameAllocators_[curFrame_]);
+    recordCulling(sprites);
+
+    auto& frame = sprites.frames_[curFrame_];
+    DrawList::IndirectData indirect{frame.visibleSprites->buffer, frame.drawCommand->buffer, texture};
+    if (deferred_ || workerPool_) {
+        drawList_.AddIndirect(indirect);
+    } else {
+        batcher_.AddIndirect(indirect);
+    }
+}
+
+void Renderer::DrawSpriteScene(SpriteScene& scene) {
+    scene.RecordUpload(prepassCmdBufs_[curFrame_], *frameAllocators_[curFrame_]);
+
+    if (deferred_ || workerPool_) {
+        drawList_.AddScene(scene);
+    } else {
+        batcher_.AddScene(scene);
+    }
+}
+
+void Renderer::recordCulling(SpriteBuffer& sprites) {
     auto& ctx = Context::Instance();
-    auto& device = ctx.device;
-    auto& cmd = cmdBufs_[curFrame_];
-    vk::DeviceSize offset = 0;
+    auto& cmd = prepassCmdBufs_[curFrame_];
+    auto& frame = sprites.frames_[curFrame_];
+
+    vk::DrawIndexedIndirectCommand drawCommand(6, 0, 0, 0, 0);
+    cmd.updateBuffer(frame.drawCommand->buffer, 0, sizeof(drawCommand), &drawCommand);
+    // the reset above and earlier sprite uploads must be done before the shader runs
+    vk::MemoryBarrier barrier;
+    barrier.setSrcAccessMask(vk::AccessFlagBits::eTransferWrite)
+           .setDstAccessMask(vk::AccessFlagBits::eShaderRead|vk::AccessFlagBits::eShaderWrite);
+    cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader,
+                        {}, barrier, {}, {});
+
+    struct {
+        float bounds[4];
+        uint32_t count;
+    } pushConstant = {
+        {viewBounds_.minX, viewBounds_.minY, viewBounds_.maxX, viewBounds_.maxY},
+        sprites.GetCount(),
+    };
+    constexpr uint32_t GroupSize = 64;
+    cmd.bindPipeline(vk::PipelineBindPoint::eCompute, ctx.renderProcess->computePipelineWithCulling);
+    cmd.bindDescriptorSets(vk::PipelineBindPoint::eCompute, ctx.renderProcess->cullLayout, 0, frame.set.set, {});
+    cmd.pushConstants(ctx.renderProcess->cullLayout, vk::ShaderStageFlagBits::eCompute, 0, sizeof(pushConstant), &pushConstant);
+    cmd.dispatch((sprites.GetCount() + GroupSize - 1) / GroupSize, 1, 1);
 
-    bufferRectData();
+    prepassUsed_ = true;
+}
 
-    cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, ctx.renderProcess->graphicsPipelineWithTriangleTopology);
-    cmd.bindVertexBuffers(0, rectVerticesBuffer_->buffer, offset);
-    cmd.bindIndexBuffer(rectIndicesBuffer_->buffer, 0, vk::IndexType::eUint32);
+void Renderer::Submit(DrawList& drawList) {
+    std::lock_guard<std::mutex> lock(submitMutex_);
+    submittedLists_.push_back(&drawList);
+}
+
+void Renderer::SetWorkerCount(uint32_t count) {
+    // secondary buffers of frames in flight are freed with their pools
+    Context::Instance().device.waitIdle();
+    workerPool_.reset();
+    recorders_.clear();
+    if (count == 0) {
+        return;
+    }
 
-    auto& layout = Context::Instance().renderProcess->layout;
-    cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics,
-                           layout,
-                           0, {descriptorSets_[curFrame_].set, texture.set.set}, {});
-    auto model = Mat4::CreateTranslate(rect.position).Mul(Mat4::CreateScale(rect.size));
-    cmd.pushConstants(layout, vk::ShaderStageFlagBits::eVertex, 0, sizeof(Mat4), model.GetData());
-    cmd.pushConstants(layout, vk::ShaderStageFlagBits::eFragment, sizeof(Mat4), sizeof(Color), &drawColor_);
-    cmd.drawIndexed(6, 1, 0, 0, 0);
+    workerPool_.reset(new WorkerPool(count));
+    recorders_.resize(maxFlightCount_);
+    for (auto& recorders : recorders_) {
+        recorders.resize(count);
+        for (auto& recorder : recorders) {
+            recorder.cmdMgr.reset(new CommandManager);
+        }
+    }
 }
 
-void Renderer::DrawLine(const Vec& p1, const Vec& p2) {
+void Renderer::recordParallel() {
     auto& ctx = Context::Instance();
-    auto& device = ctx.device;
-    auto& cmd = cmdBufs_[curFrame_];
-    vk::DeviceSize offset = 0;
+    std::vector<DrawList*> lists;
+    lists.push_back(&drawList_);
+    {
+        std::lock_guard<std::mutex> lock(submitMutex_);
+        lists.insert(lists.end(), submittedLists_.begin(), submittedLists_.end());
+        submittedLists_.clear();
+    }
 
-    bufferLineData(p1, p2);
+    struct Result {
+        vk::CommandBuffer cmd;
+        StateCache::Stats stats;
+        CullStats cullStats;
+    };
+    std::vector<Result> results(lists.size());
+    auto resources = getFrameResources();
+
+    vk::CommandBufferInheritanceInfo inheritance;
+    inheritance.setRenderPass(ctx.renderProcess->renderPass)
+               .setSubpass(0)
+               .setFramebuffer(ctx.swapchain->framebuffers[imageIndex_]);
 
-    cmd.bindPipeline(vk::PipelineBindPoint::eGraphics, ctx.renderProcess->graphicsPipelineWithLineTopology);
-    cmd.bindVertexBuffers(0, lineVerticesBuffer_->buffer, offset);
+    for (size_t i = 0; i < lists.size(); i++) {
+        if (lists[i]->Empty()) {
+            continue;
+        }
+        workerPool_->Enqueue([&, i](uint32_t worker) {
+            auto& recorder = recorders_[curFrame_][worker];
+            if (recorder.usedCount == recorder.cmdBufs.size()) {
+                recorder.cmdBufs.push_back(recorder.cmdMgr->CreateCommandBuffers(1, vk::CommandBufferLevel::eSecondary)[0]);
+            }
+            auto cmd = recorder.cmdBufs[recorder.usedCount++];
+
+            vk::CommandBufferBeginInfo beginInfo;
+            beginInfo.setFlags(vk::CommandBufferUsageFlagBits::eRenderPassContinue|vk::CommandBufferUsageFlagBits::eOneTimeSubmit)
+                     .setPInheritanceInfo(&inheritance);
+            cmd.begin(beginInfo);
+            recorder.batcher.Begin(cmd, resources);
+            recorder.batcher.Record(*lists[i]);
+            recorder.batcher.Flush();
+            cmd.end();
+
+            results[i].cmd = cmd;
+            results[i].stats = recorder.batcher.GetStats();
+            results[i].cullStats = recorder.batcher.GetCullStats();
+        });
+    }
 
-    auto& layout = Context::Instance().renderProcess->layout;
-    cmd.bindDescriptorSets(vk::PipelineBindPoint::eGraphics,
-                           layout,
-                           0, {descriptorSets_[curFrame_].set, whiteTexture->set.set}, {});
-    auto model = Mat4::CreateIdentity();
-    cmd.pushConstants(layout, vk::ShaderStageFlagBits::eVertex, 0, sizeof(Mat4), model.GetData());
-    cmd.pushConstants(layout, vk::ShaderStageFlagBits::eFragment, sizeof(Mat4), sizeof(Color), &drawColor_);
-    cmd.draw(2, 1, 0, 0);
+    beginRenderPass(vk::SubpassContents::eSecondaryCommandBuffers);
+    workerPool_->Wait();
+
+    frameStats_ = StateCache::Stats{};
+    cullStats_ = CullStats{};
+    std::vector<vk::CommandBuffer> cmds;
+    for (auto& result : results) {
+        if (result.cmd) {
+            cmds.push_back(result.cmd);
+            frameStats_ += result.stats;
+            cullStats_ += result.cullStats;
+        }
+    }
+    if (!cmds.empty()) {
+        cmdBufs_[curFrame_].executeCommands(cmds);
+    }
 }
 
 void Renderer::EndRender() {
     auto& ctx = Context::Instance();
     auto& swapchain = ctx.swapchain;
     auto& cmd = cmdBufs_[curFrame_];
+    if (workerPool_) {
+        recordParallel();
+    } else {
+        batcher_.Record(drawList_);
+        {
+            std::lock_guard<std::mutex> lock(submitMutex_);
+            for (auto list : submittedLists_) {
+                batcher_.Record(*list);
+            }
+            submittedLists_.clear();
+        }
+        batcher_.Flush();
+        frameStats_ = batcher_.GetStats();
+        cullStats_ = batcher_.GetCullStats();
+    }
     cmd.endRenderPass();
     cmd.end();
 
+    auto& prepassCmd = prepassCmdBufs_[curFrame_];
+    if (prepassUsed_) {
+        // culled sprites and their draw commands are read by the render pass
+        vk::MemoryBarrier barrier;
+        barrier.setSrcAccessMask(vk::AccessFlagBits::eShaderWrite)
+               .setDstAccessMask(vk::AccessFlagBits::eIndirectCommandRead|vk::AccessFlagBits::eVertexAttributeRead);
+        prepassCmd.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader,
+                                   vk::PipelineStageFlagBits::eDrawIndirect|vk::PipelineStageFlagBits::eVertexInput,
+                                   {}, barrier, {}, {});
+    }
+    prepassCmd.end();
+
+    std::array<vk::CommandBuffer, 2> cmds = {prepassCmd, cmd};
     vk::SubmitInfo submit;
     vk::PipelineStageFlags flags = vk::PipelineStageFlagBits::eColorAttachmentOutput;
-    submit.setCommandBuffers(cmd)
+    submit.setCommandBuffers(cmds)
           .setWaitSemaphores(imageAvaliableSems_[curFrame_])
           .setWaitDstStageMask(flags)
           .setSignalSemaphores(renderFinishSems_[curFrame_]);
+
+    // textures drawn this frame were ready when recorded, waiting on the value the
+    // upload timeline has reached by now makes their uploads visible to the shaders
+    std::array<vk::Semaphore, 2> waitSems;
+    std::array<vk::PipelineStageFlags, 2> waitStages;
+    std::array<uint64_t, 2> waitValues;
+    uint64_t signalValue = 0;
+    vk::TimelineSemaphoreSubmitInfo timelineInfo;
+    uint64_t uploaded = ctx.uploadQueue ? ctx.uploadQueue->GetCompletedValue() : 0;
+    if (uploaded > 0) {
+        waitSems = {imageAvaliableSems_[curFrame_], ctx.uploadQueue->GetSemaphore()};
+        waitStages = {flags, vk::PipelineStageFlagBits::eVertexShader|vk::PipelineStageFlagBits::eFragmentShader};
+        // binary semaphores ignore their values
+        waitValues = {0, uploaded};
+        timelineInfo.setWaitSemaphoreValues(waitValues)
+                    .setSignalSemaphoreValues(signalValue);
+        submit.setWaitSemaphores(waitSems)
+              .setWaitDstStageMask(waitStages)
+              .setPNext(&timelineInfo);
+    }
     ctx.graphicsQueue.submit(submit, fences_[curFrame_]);
 
     vk::PresentInfoKHR presentInfo;
@@ -134,6 +368,7 @@ void Renderer::EndRender() {
     }
 
     curFrame_ = (curFrame_ + 1) % maxFlightCount_;
+    inFrame_ = false;
 }
 
 void Renderer::createFences() {
@@ -163,54 +398,45 @@ void Renderer::createSemaphores() {
 }
 
 void Renderer::createCmdBuffers() {
-    cmdBufs_.resize(maxFlightCount_);
-
-    for (auto& cmd : cmdBufs_) {
-        cmd = Context::Instance().commandManager->CreateOneCommandBuffer();
-    }
+    cmdBufs_ = Context::Instance().commandManager->CreateCommandBuffers(maxFlightCount_);
+    prepassCmdBufs_ = Context::Instance().commandManager->CreateCommandBuffers(maxFlightCount_);
 }
 
 void Renderer::createBuffers() {
-    auto& device = Context::Instance().device;
+    frameAllocators_.resize(maxFlightCount_);
+    for (auto& allocator : frameAllocators_) {
+        allocator.reset(new FrameAllocator(1024 * 1024));
+    }
 
-    rectVerticesBuffer_.reset(new Buffer(vk::BufferUsageFlagBits::eVertexBuffer,
+    rectVerticesBuffer_.reset(new Buffer(vk::BufferUsageFlagBits::eVertexBuffer|vk::BufferUsageFlagBits::eTransferDst,
                                      sizeof(Vertex) * 4,
-                                     vk::MemoryPropertyFlagBits::eHostVisible|vk::MemoryPropertyFlagBits::eHostCoherent));
+                                     vk::MemoryPropertyFlagBits::eDeviceLocal));
 
-    rectIndicesBuffer_.reset(new Buffer(vk::BufferUsageFlagBits::eIndexBuffer,
+    rectIndicesBuffer_.reset(new Buffer(vk::BufferUsageFlagBits::eIndexBuffer|vk::BufferUsageFlagBits::eTransferDst,
                                      sizeof(uint32_t) * 6,
-                                     vk::MemoryPropertyFlagBits::eHostVisible|vk::MemoryPropertyFlagBits::eHostCoherent));
-
-    lineVerticesBuffer_.reset(new Buffer(vk::BufferUsageFlagBits::eVertexBuffer,
-                                         sizeof(Vertex) * 2,
-                                         vk::MemoryPropertyFlagBits::eHostVisible|vk::MemoryPropertyFlagBits::eHostCoherent));
+                                     vk::MemoryPropertyFlagBits::eDeviceLocal));
+    bufferRectData();
 }
 
 void Renderer::createUniformBuffers(int flightCount) {
     uniformBuffers_.resize(flightCount);
-    //            two mat4                  one color
+    //            two mat4
     size_t size = sizeof(Mat4) * 2;
     for (auto& buffer : uniformBuffers_) {
-        buffer.reset(new Buffer(vk::BufferUsageFlagBits::eTransferSrc,
+        buffer.reset(new Buffer(vk::BufferUsageFlagBits::eUniformBuffer,
                      size,
                      vk::MemoryPropertyFlagBits::eHostVisible|vk::MemoryPropertyFlagBits::eHostCoherent));
     }
-    deviceUniformBuffers_.resize(flightCount);
-    for (auto& buffer : deviceUniformBuffers_) {
-        buffer.reset(new Buffer(vk::BufferUsageFlagBits::eTransferDst|vk::BufferUsageFlagBits::eUniformBuffer,
-                     size,
-                     vk::MemoryPropertyFlagBits::eDeviceLocal));
-    }
 }
 
-void Renderer::transformBuffer2Device(Buffer& src, Buffer& dst, size_t srcOffset, size_t dstOffset, size_t size) {
+void Renderer::transformBuffer2Device(vk::Buffer src, Buffer& dst, size_t srcOffset, size_t dstOffset, size_t size) {
     Context::Instance().commandManager->ExecuteCmd(Context::Instance().graphicsQueue,
             [&](vk::CommandBuffer& cmdBuf) {
                 vk::BufferCopy region;
                 region.setSrcOffset(srcOffset)
                       .setDstOffset(dstOffset)
                       .setSize(size);
-                cmdBuf.copyBuffer(src.buffer, dst.buffer, region);
+                cmdBuf.copyBuffer(src, dst.buffer, region);
             });
 }
 
@@ -228,51 +454,38 @@ std::uint32_t Renderer::queryBufferMemTypeIndex(std::uint32_t type, vk::MemoryPr
 }
 
 void Renderer::bufferRectData() {
-    bufferRectVertexData();
-    bufferRectIndicesData();
-}
-
-void Renderer::bufferRectVertexData() {
+    // the unit quad never changes, upload it once into device local memory
     Vertex vertices[] = {
-        {Vec{-0.5, -0.5},Vec{0, 0}},
-        {Vec{0.5, -0.5} ,Vec{1, 0}},
-        {Vec{0.5, 0.5}  ,Vec{1, 1}},
-        {Vec{-0.5, 0.5} ,Vec{0, 1}},
+        {Vec{-0.5, -0.5},Vec{0, 0},Color{1, 1, 1}},
+        {Vec{0.5, -0.5} ,Vec{1, 0},Color{1, 1, 1}},
+        {Vec{0.5, 0.5}  ,Vec{1, 1},Color{1, 1, 1}},
+        {Vec{-0.5, 0.5} ,Vec{0, 1},Color{1, 1, 1}},
     };
-    auto& device = Context::Instance().device;
-    memcpy(rectVerticesBuffer_->map, vertices, sizeof(vertices));
-}
-
-void Renderer::bufferRectIndicesData() {
     std::uint32_t indices[] = {
         0, 1, 3,
         1, 2, 3,
     };
-    auto& device = Context::Instance().device;
-    memcpy(rectIndicesBuffer_->map, indices, sizeof(indices));
-}
 
-void Renderer::bufferLineData(const Vec& p1, const Vec& p2) {
-    Vertex vertices[] = {
-        {p1,Vec{0, 0}},
-        {p2,Vec{0, 0}},
-    };
-    auto& device = Context::Instance().device;
-    memcpy(lineVerticesBuffer_->map, vertices, sizeof(vertices));
+    auto& stagingPool = Context::Instance().stagingPool;
+    auto stage = stagingPool->Allocate(sizeof(vertices) + sizeof(indices));
+    memcpy(stage.map, vertices, sizeof(vertices));
+    memcpy((char*)stage.map + sizeof(vertices), indices, sizeof(indices));
+    transformBuffer2Device(stage.buffer, *rectVerticesBuffer_, stage.offset, 0, sizeof(vertices));
+    transformBuffer2Device(stage.buffer, *rectIndicesBuffer_, stage.offset + sizeof(vertices), 0, sizeof(indices));
+    stagingPool->Release(stage);
 }
 
 void Renderer::bufferMVPData() {
-    struct Matrices {
-        Mat4 project;
-        Mat4 view;
-    } matrices;
-    auto& device = Context::Instance().device;
-    for (int i = 0; i < uniformBuffers_.size(); i++) {
-        auto& buffer = uniformBuffers_[i];
-        memcpy(buffer->map, (void*)&projectMat_, sizeof(Mat4));
-        memcpy(((float*)buffer->map + 4 * 4), (void*)&viewMat_, sizeof(Mat4));
-        transformBuffer2Device(*buffer, *deviceUniformBuffers_[i], 0, 0, buffer->size);
-    }
+    // only the current frame's buffer is free, the others may still be read by the GPU
+    auto& buffer = uniformBuffers_[curFrame_];
+    memcpy(buffer->map, (void*)&projectMat_, sizeof(Mat4));
+    memcpy(((float*)buffer->map + 4 * 4), (void*)&viewMat_, sizeof(Mat4));
+}
+
+void Renderer::SetBindless(bool bindless) {
+    bool enable = bindless && Context::Instance().bindlessInfo.supported;
+    bindless_ = enable;
+    batcher_.SetBindless(enable);
 }
 
 void Renderer::SetDrawColor(const Color& color) {
@@ -280,20 +493,67 @@ void Renderer::SetDrawColor(const Color& color) {
 }
 
 void Renderer::initMats() {
-    viewMat_ = Mat4::CreateIdentity();
     projectMat_ = Mat4::CreateIdentity();
+    projectBounds_ = {-1, -1, 1, 1};
+    updateView();
 }
 
 void Renderer::SetProject(int right, int left, int bottom, int top, int far, int near) {
     projectMat_ = Mat4::CreateOrtho(left, right, top, bottom, near, far);
-    bufferMVPData();
+    projectBounds_.minX = std::min(left, right);
+    projectBounds_.maxX = std::max(left, right);
+    projectBounds_.minY = std::min(top, bottom);
+    projectBounds_.maxY = std::max(top, bottom);
+    updateView();
+}
+
+void Renderer::SetView(const Vec& position, float zoom) {
+    viewPosition_ = position;
+    viewZoom_ = zoom;
+    updateView();
+}
+
+void Renderer::Pan(const Vec& delta) {
+    viewPosition_.x += delta.x;
+    viewPosition_.y += delta.y;
+    updateView();
+}
+
+void Renderer::Zoom(float factor) {
+    float centerX = (projectBounds_.minX + projectBounds_.maxX) * 0.5f;
+    float centerY = (projectBounds_.minY + projectBounds_.maxY) * 0.5f;
+    float zoom = viewZoom_ * factor;
+    viewPosition_.x += centerX / viewZoom_ - centerX / zoom;
+    viewPosition_.y += centerY / viewZoom_ - centerY / zoom;
+    viewZoom_ = zoom;
+    updateView();
+}
+
+void Renderer::updateView() {
+    // view = scale(zoom) * translate(-position)
+    viewMat_ = Mat4::CreateIdentity();
+    viewMat_.Set(0, 0, viewZoom_);
+    viewMat_.Set(1, 1, viewZoom_);
+    viewMat_.Set(3, 0, -viewPosition_.x * viewZoom_);
+    viewMat_.Set(3, 1, -viewPosition_.y * viewZoom_);
+
+    viewBounds_.minX = projectBounds_.minX / viewZoom_ + viewPosition_.x;
+    viewBounds_.maxX = projectBounds_.maxX / viewZoom_ + viewPosition_.x;
+    viewBounds_.minY = projectBounds_.minY / viewZoom_ + viewPosition_.y;
+    viewBounds_.maxY = projectBounds_.maxY / viewZoom_ + viewPosition_.y;
+
+    // outside a frame StartRender writes the uniforms, the current buffer may be in use now
+    if (inFrame_) {
+        bufferMVPData();
+        batcher_.SetBounds(viewBounds_);
+    }
 }
 
 void Renderer::updateDescriptorSets() {
     for (int i = 0; i < descriptorSets_.size(); i++) {
         // bind MVP buffer
         vk::DescriptorBufferInfo bufferInfo1;
-        bufferInfo1.setBuffer(deviceUniformBuffers_[i]->buffer)
+        bufferInfo1.setBuffer(uniformBuffers_[i]->buffer)
                    .setOffset(0)
 				   .setRange(sizeof(Mat4) * 2);
 
@@ -4,16 +4,34 @@
 
 namespace toy2d {
 
-Shader::Shader(const std::vector<char>& vertexSource, const std::vector<char>& fragSource) {
-    vk::ShaderModuleCreateInfo vertexModuleCreateInfo, fragModuleCreateInfo;
+Shader::Shader(std::string_view vertexSource,
+               std::string_view spriteVertexSource,
+               std::string_view fragSource,
+               std::string_view bindlessFragSource,
+               std::string_view cullCompSource) {
+    vk::ShaderModuleCreateInfo vertexModuleCreateInfo, spriteVertexModuleCreateInfo, fragModuleCreateInfo, cullCompModuleCreateInfo;
     vertexModuleCreateInfo.codeSize = vertexSource.size();
     vertexModuleCreateInfo.pCode = (std::uint32_t*)vertexSource.data();
+    spriteVertexModuleCreateInfo.codeSize = spriteVertexSource.size();
+    spriteVertexModuleCreateInfo.pCode = (std::uint32_t*)spriteVertexSource.data();
     fragModuleCreateInfo.codeSize = fragSource.size();
     fragModuleCreateInfo.pCode = (std::uint32_t*)fragSource.data();
+    cullCompModuleCreateInfo.codeSize = cullCompSource.size();
+    cullCompModuleCreateInfo.pCode = (std::uint32_t*)cullCompSource.data();
 
     auto& device = Context::Instance().device;
     vertexModule_ = device.createShaderModule(vertexModuleCreateInfo);
+    spriteVertexModule_ = device.createShaderModule(spriteVertexModuleCreateInfo);
     fragModule_ = device.createShaderModule(fragModuleCreateInfo);
+    cullCompModule_ = device.createShaderModule(cullCompModuleCreateInfo);
+
+    // the bindless shader needs runtime descriptor arrays, don't even create it without them
+    if (Context::Instance().bindlessInfo.supported) {
+        vk::ShaderModuleCreateInfo bindlessFragModuleCreateInfo;
+        bindlessFragModuleCreateInfo.codeSize = bindlessFragSource.size();
+        bindlessFragModuleCreateInfo.pCode = (std::uint32_t*)bindlessFragSource.data();
+        bindlessFragModule_ = device.createShaderModule(bindlessFragModuleCreateInfo);
+    }
 
     initDescriptorSetLayouts();
 }
@@ -37,6 +55,39 @@ void Shader::initDescriptorSetLayouts() {
     createInfo.setBindings(bindings);
 
     layouts_.push_back(Context::Instance().device.createDescriptorSetLayout(createInfo));
+
+    auto& bindlessInfo = Context::Instance().bindlessInfo;
+    if (bindlessInfo.supported) {
+        // set 2: one big texture table shared by all textures, indexed per sprite instance
+        bindings.resize(1);
+        bindings[0].setBinding(0)
+                   .setDescriptorCount(bindlessInfo.maxTextureCount)
+                   .setDescriptorType(vk::DescriptorType::eCombinedImageSampler)
+                   .setStageFlags(vk::ShaderStageFlagBits::eFragment);
+        vk::DescriptorBindingFlags bindingFlags = vk::DescriptorBindingFlagBits::ePartiallyBound|
+                                                  vk::DescriptorBindingFlagBits::eUpdateAfterBind|
+                                                  vk::DescriptorBindingFlagBits::eUpdateUnusedWhilePending;
+        vk::DescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo;
+        bindingFlagsInfo.setBindingFlags(bindingFlags);
+        createInfo.setBindings(bindings)
+                  .setFlags(vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool)
+                  .setPNext(&bindingFlagsInfo);
+
+        layouts_.push_back(Context::Instance().device.createDescriptorSetLayout(createInfo));
+    }
+
+    // culling: all sprites, visible sprites and the indirect draw command
+    vk::DescriptorSetLayoutCreateInfo cullCreateInfo;
+    bindings.resize(3);
+    for (uint32_t i = 0; i < bindings.size(); i++) {
+        bindings[i].setBinding(i)
+                   .setDescriptorCount(1)
+                   .setDescriptorType(vk::DescriptorType::eStorageBuffer)
+                   .setStageFlags(vk::ShaderStageFlagBits::eCompute);
+    }
+    cullCreateInfo.setBindings(bindings);
+
+    cullLayout_ = Context::Instance().device.createDescriptorSetLayout(cullCreateInfo);
 }
 
 Shader::~Shader() {
@@ -45,18 +96,30 @@ Shader::~Shader() {
         device.destroyDescriptorSetLayout(layout);
     }
     layouts_.clear();
+    device.destroyDescriptorSetLayout(cullLayout_);
     device.destroyShaderModule(vertexModule_);
+    device.destroyShaderModule(spriteVertexModule_);
     device.destroyShaderModule(fragModule_);
+    device.destroyShaderModule(cullCompModule_);
+    if (bindlessFragModule_) {
+        device.destroyShaderModule(bindlessFragModule_);
+    }
 }
 
 std::vector<vk::PushConstantRange> Shader::GetPushConstantRange() const {
-    std::vector<vk::PushConstantRange> ranges(2);
+    std::vector<vk::PushConstantRange> ranges(1);
     ranges[0].setOffset(0)
              .setSize(sizeof(Mat4))
              .setStageFlags(vk::ShaderStageFlagBits::eVertex);
-    ranges[1].setOffset(sizeof(Mat4))
-             .setSize(sizeof(Color))
-             .setStageFlags(vk::ShaderStageFlagBits::eFragment);
+    return ranges;
+}
+
+std::vector<vk::PushConstantRange> Shader::GetCullPushConstantRange() const {
+    std::vector<vk::PushConstantRange> ranges(1);
+    //                      bounds                count
+    ranges[0].setOffset(0)
+             .setSize(sizeof(float) * 4 + sizeof(uint32_t))
+             .setStageFlags(vk::ShaderStageFlagBits::eCompute);
     return ranges;
 }
 
@@ -0,0 +1,211 @@
+#include "toy2d/spatial_grid.hpp"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace toy2d {
+
+SpatialGrid::SpatialGrid(float cellSize): cellSize_(cellSize) {}
+
+uint64_t SpatialGrid::cellKey(int32_t x, int32_t y) {
+    return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+}
+
+ViewBounds SpatialGrid::toBounds(const Rect& rect) {
+    float halfW = std::abs(rect.size.w) * 0.5f;
+    float halfH = std::abs(rect.size.h) * 0.5f;
+    return ViewBounds{rect.position.x - halfW, rect.position.y - halfH,
+                      rect.position.x + halfW, rect.position.y + halfH};
+}
+
+int32_t SpatialGrid::toCell(float coord) const {
+    // clamped before the cast, which is undefined out of range. NaN goes to the low border
+    float cell = std::floor(coord / cellSize_);
+    if (!(cell > -MaxCell)) {
+        return -MaxCell;
+    }
+    if (cell > MaxCell) {
+        return MaxCell;
+    }
+    return static_cast<int32_t>(cell);
+}
+
+int64_t SpatialGrid::cellCount(const CellRange& range) {
+    return (int64_t(range.maxX) - range.minX + 1) * (int64_t(range.maxY) - range.minY + 1);
+}
+
+SpatialGrid::CellRange SpatialGrid::toCellRange(const ViewBounds& bounds) const {
+    return CellRange{toCell(bounds.minX), toCell(bounds.minY), toCell(bounds.maxX), toCell(bounds.maxY)};
+}
+
+void SpatialGrid::addToCells(uint32_t id, const CellRange& range) {
+    for (int32_t y = range.minY; y <= range.maxY; y++) {
+        for (int32_t x = range.minX; x <= range.maxX; x++) {
+            cells_[cellKey(x, y)].push_back(id);
+        }
+    }
+}
+
+void SpatialGrid::removeFromCells(uint32_t id, const CellRange& range) {
+    for (int32_t y = range.minY; y <= range.maxY; y++) {
+        for (int32_t x = range.minX; x <= range.maxX; x++) {
+            auto it = cells_.find(cellKey(x, y));
+            if (it == cells_.end()) {
+                continue;
+            }
+            auto& ids = it->second;
+            auto found = std::find(ids.begin(), ids.end(), id);
+            if (found != ids.end()) {
+                *found = ids.back();
+                ids.pop_back();
+            }
+            if (ids.empty()) {
+                cells_.erase(it);
+            }
+        }
+    }
+}
+
+void SpatialGrid::link(uint32_t id) {
+    auto& item = items_[id];
+    item.large = cellCount(item.cells) > MaxItemCells;
+    if (item.large) {
+        item.largeIndex = largeItems_.size();
+        largeItems_.push_back(id);
+    } else {
+        addToCells(id, item.cells);
+    }
+}
+
+void SpatialGrid::unlink(uint32_t id) {
+    auto& item = items_[id];
+    if (!item.large) {
+        removeFromCells(id, item.cells);
+        return;
+    }
+    uint32_t last = largeItems_.back();
+    largeItems_[item.largeIndex] = last;
+    items_[last].largeIndex = item.largeIndex;
+    largeItems_.pop_back();
+    item.large = false;
+}
+
+void SpatialGrid::Insert(uint32_t id, const Rect& rect) {
+    if (id >= items_.size()) {
+        items_.resize(id + 1);
+    }
+    auto& item = items_[id];
+    if (item.valid) {
+        throw std::runtime_error("id is already in the spatial grid");
+    }
+
+    item.bounds = toBounds(rect);
+    item.cells = toCellRange(item.bounds);
+    item.valid = true;
+    link(id);
+}
+
+void SpatialGrid::Move(uint32_t id, const Rect& rect) {
+    auto& item = items_.at(id);
+    if (!item.valid) {
+        throw std::runtime_error("id is not in the spatial grid");
+    }
+    item.bounds = toBounds(rect);
+    auto cells = toCellRange(item.bounds);
+    if (cells == item.cells) {
+        return;
+    }
+
+    unlink(id);
+    item.cells = cells;
+    link(id);
+}
+
+void SpatialGrid::Remove(uint32_t id) {
+    auto& item = items_.at(id);
+    if (!item.valid) {
+        return;
+    }
+    unlink(id);
+    item.valid = false;
+}
+
+void SpatialGrid::Clear() {
+    items_.clear();
+    cells_.clear();
+    largeItems_.clear();
+}
+
+void SpatialGrid::reportFromCell(int32_t x, int32_t y, const CellRange& range, const std::vector<uint32_t>& ids,
+                                 const ViewBounds& bounds, std::vector<uint32_t>& result) const {
+    for (auto id : ids) {
+        auto& item = items_[id];
+        // a rect spanning several queried cells is only reported from the
+        // first cell shared by both ranges, no per query bookkeeping needed
+        if (x != std::max(item.cells.minX, range.minX) ||
+            y != std::max(item.cells.minY, range.minY)) {
+            continue;
+        }
+        if (item.bounds.maxX >= bounds.minX && item.bounds.minX <= bounds.maxX &&
+            item.bounds.maxY >= bounds.minY && item.bounds.minY <= bounds.maxY) {
+            result.push_back(id);
+        }
+    }
+}
+
+void SpatialGrid::QueryRect(const ViewBounds& bounds, std::vector<uint32_t>& result) const {
+    for (auto id : largeItems_) {
+        auto& item = items_[id];
+        if (item.bounds.maxX >= bounds.minX && item.bounds.minX <= bounds.maxX &&
+            item.bounds.maxY >= bounds.minY && item.bounds.minY <= bounds.maxY) {
+            result.push_back(id);
+        }
+    }
+
+    // a query larger than the occupied cells (zoomed far out) walks the occupied cells
+    // instead, so its cost stays bound by the content
+    auto range = toCellRange(bounds);
+    if (cellCount(range) > static_cast<int64_t>(cells_.size())) {
+        for (auto& [key, ids] : cells_) {
+            int32_t x = static_cast<int32_t>(key >> 32);
+            int32_t y = static_cast<int32_t>(static_cast<uint32_t>(key));
+            if (x >= range.minX && x <= range.maxX && y >= range.minY && y <= range.maxY) {
+                reportFromCell(x, y, range, ids, bounds, result);
+            }
+        }
+        return;
+    }
+
+    for (int32_t y = range.minY; y <= range.maxY; y++) {
+        for (int32_t x = range.minX; x <= range.maxX; x++) {
+            auto it = cells_.find(cellKey(x, y));
+            if (it != cells_.end()) {
+                reportFromCell(x, y, range, it->second, bounds, result);
+            }
+        }
+    }
+}
+
+void SpatialGrid::QueryPoint(const Vec& point, std::vector<uint32_t>& result) const {
+    for (auto id : largeItems_) {
+        auto& item = items_[id];
+        if (point.x >= item.bounds.minX && point.x <= item.bounds.maxX &&
+            point.y >= item.bounds.minY && point.y <= item.bounds.maxY) {
+            result.push_back(id);
+        }
+    }
+
+    auto it = cells_.find(cellKey(toCell(point.x), toCell(point.y)));
+    if (it == cells_.end()) {
+        return;
+    }
+    for (auto id : it->second) {
+        auto& item = items_[id];
+        if (point.x >= item.bounds.minX && point.x <= item.bounds.maxX &&
+            point.y >= item.bounds.minY && point.y <= item.bounds.maxY) {
+            result.push_back(id);
+        }
+    }
+}
+
+}
@@ -0,0 +1,106 @@
+#include "toy2d/sprite_buffer.hpp"
+#include "toy2d/context.hpp"
+
+namespace toy2d {
+
+SpriteBuffer::SpriteBuffer(uint32_t capacity): capacity_(capacity) {
+    sprites_.reset(new Buffer(vk::BufferUsageFlagBits::eStorageBuffer|vk::BufferUsageFlagBits::eTransferDst,
+                              sizeof(SpriteInstance) * capacity,
+                              vk::MemoryPropertyFlagBits::eDeviceLocal));
+
+    frames_.resize(DescriptorSetManager::Instance().GetMaxFlight());
+    for (auto& frame : frames_) {
+        frame.visibleSprites.reset(new Buffer(vk::BufferUsageFlagBits::eStorageBuffer|vk::BufferUsageFlagBits::eVertexBuffer,
+                                              sizeof(SpriteInstance) * capacity,
+                                              vk::MemoryPropertyFlagBits::eDeviceLocal));
+        frame.drawCommand.reset(new Buffer(vk::BufferUsageFlagBits::eStorageBuffer|
+                                           vk::BufferUsageFlagBits::eIndirectBuffer|
+                                           vk::BufferUsageFlagBits::eTransferDst,
+                                           sizeof(vk::DrawIndexedIndirectCommand),
+                                           vk::MemoryPropertyFlagBits::eDeviceLocal));
+        frame.set = DescriptorSetManager::Instance().AllocCullSet();
+        updateDescriptorSet(frame);
+    }
+}
+
+SpriteBuffer::~SpriteBuffer() {
+    // the buffers and sets go once frames drawing them finished
+    auto& deletionQueue = Context::Instance().deletionQueue;
+    for (auto& frame : frames_) {
+        deletionQueue->Push([set = frame.set]() {
+            DescriptorSetManager::Instance().FreeCullSet(set);
+        });
+        deletionQueue->Retire(std::move(frame.visibleSprites));
+        deletionQueue->Retire(std::move(frame.drawCommand));
+    }
+    deletionQueue->Retire(std::move(sprites_));
+}
+
+void SpriteBuffer::updateDescriptorSet(FrameData& frame) {
+    std::array<vk::DescriptorBufferInfo, 3> bufferInfos;
+    bufferInfos[0].setBuffer(sprites_->buffer)
+                  .setOffset(0)
+                  .setRange(VK_WHOLE_SIZE);
+    bufferInfos[1].setBuffer(frame.visibleSprites->buffer)
+                  .setOffset(0)
+                  .setRange(VK_WHOLE_SIZE);
+    bufferInfos[2].setBuffer(frame.drawCommand->buffer)
+                  .setOffset(0)
+                  .setRange(VK_WHOLE_SIZE);
+
+    std::array<vk::WriteDescriptorSet, 3> writeInfos;
+    for (uint32_t i = 0; i < writeInfos.size(); i++) {
+        writeInfos[i].setBufferInfo(bufferInfos[i])
+                     .setDstBinding(i)
+                     .setDescriptorType(vk::DescriptorType::eStorageBuffer)
+                     .setDescriptorCount(1)
+                     .setDstArrayElement(0)
+                     .setDstSet(frame.set.set);
+    }
+
+    Context::Instance().device.updateDescriptorSets(writeInfos, {});
+}
+
+void SpriteBuffer::Upload(const SpriteInstance* instances, uint32_t count, uint32_t first) {
+    if (first + count > capacity_) {
+        throw std::runtime_error("sprite buffer upload out of range");
+    }
+    if (count == 0) {
+        return;
+    }
+
+    vk::BufferCopy region;
+    region.setSrcOffset(sizeof(SpriteInstance) * pending_.size())
+          .setDstOffset(sizeof(SpriteInstance) * first)
+          .setSize(sizeof(SpriteInstance) * count);
+    pendingRegions_.push_back(region);
+    pending_.insert(pending_.end(), instances, instances + count);
+}
+
+void SpriteBuffer::recordUpload(vk::CommandBuffer cmd, FrameAllocator& allocator) {
+    if (pendingRegions_.empty()) {
+        return;
+    }
+
+    size_t size = sizeof(SpriteInstance) * pending_.size();
+    auto staging = allocator.Allocate(size);
+    memcpy(staging.map, pending_.data(), size);
+    for (auto& region : pendingRegions_) {
+        region.srcOffset += staging.offset;
+    }
+
+    // culling of earlier frames may still read the instances, wait for it before overwriting.
+    // The barrier in front of this frame's culling makes the copy visible to it
+    cmd.pipelineBarrier(vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eTransfer,
+                        {}, {}, {}, {});
+    cmd.copyBuffer(staging.buffer, sprites_->buffer, pendingRegions_);
+
+    pending_.clear();
+    pendingRegions_.clear();
+}
+
+void SpriteBuffer::SetCount(uint32_t count) {
+    count_ = std::min(count, capacity_);
+}
+
+}
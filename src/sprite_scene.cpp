@@ -0,0 +1,165 @@
+#include "toy2d/sprite_scene.hpp"
+#include "toy2d/context.hpp"
+#include <algorithm>
+
+namespace toy2d {
+
+SpriteScene::SpriteScene(uint32_t capacity, float gridCellSize): capacity_(capacity), grid_(gridCellSize) {
+    buffer_.reset(new Buffer(vk::BufferUsageFlagBits::eVertexBuffer|
+                             vk::BufferUsageFlagBits::eStorageBuffer|
+                             vk::BufferUsageFlagBits::eTransferDst,
+                             sizeof(SpriteInstance) * capacity,
+                             vk::MemoryPropertyFlagBits::eDeviceLocal));
+    dirtyPages_.resize((capacity + PageSize - 1) / PageSize, false);
+}
+
+SpriteScene::~SpriteScene() {
+    // frames in flight may still read the instances
+    Context::Instance().deletionQueue->Retire(std::move(buffer_));
+}
+
+SpriteScene::Handle SpriteScene::Create(const Rect& rect, Texture& texture, const Color& color) {
+    if (instances_.size() == capacity_) {
+        throw std::runtime_error("sprite scene is full");
+    }
+
+    Handle handle;
+    if (!freeHandles_.empty()) {
+        handle = freeHandles_.back();
+        freeHandles_.pop_back();
+    } else {
+        handle = indices_.size();
+        indices_.push_back(0);
+    }
+
+    uint32_t index = instances_.size();
+    indices_[handle] = index;
+    instances_.push_back(SpriteInstance{rect.position, rect.size, texture.uv, color.Pack(), texture.bindlessIndex});
+    textures_.push_back(&texture);
+    handles_.push_back(handle);
+    grid_.Insert(handle, rect);
+    markDirty(index);
+    return handle;
+}
+
+void SpriteScene::Destroy(Handle handle) {
+    uint32_t index = getIndex(handle);
+    uint32_t last = instances_.size() - 1;
+    if (index != last) {
+        instances_[index] = instances_[last];
+        textures_[index] = textures_[last];
+        handles_[index] = handles_[last];
+        indices_[handles_[index]] = index;
+        markDirty(index);
+    }
+    instances_.pop_back();
+    textures_.pop_back();
+    handles_.pop_back();
+
+    indices_[handle] = InvalidHandle;
+    freeHandles_.push_back(handle);
+    grid_.Remove(handle);
+}
+
+void SpriteScene::SetRect(Handle handle, const Rect& rect) {
+    uint32_t index = getIndex(handle);
+    instances_[index].position = rect.position;
+    instances_[index].size = rect.size;
+    grid_.Move(handle, rect);
+    markDirty(index);
+}
+
+void SpriteScene::SetColor(Handle handle, const Color& color) {
+    uint32_t index = getIndex(handle);
+    instances_[index].color = color.Pack();
+    markDirty(index);
+}
+
+void SpriteScene::SetTexture(Handle handle, Texture& texture) {
+    uint32_t index = getIndex(handle);
+    instances_[index].uv = texture.uv;
+    instances_[index].texture = texture.bindlessIndex;
+    textures_[index] = &texture;
+    markDirty(index);
+}
+
+void SpriteScene::GatherVisible(const ViewBounds& bounds, std::vector<uint32_t>& indices) const {
+    size_t begin = indices.size();
+    grid_.QueryRect(bounds, indices);
+    for (size_t i = begin; i < indices.size(); i++) {
+        indices[i] = indices_[indices[i]];
+    }
+    std::sort(indices.begin() + begin, indices.end());
+}
+
+uint32_t SpriteScene::getIndex(Handle handle) const {
+    if (handle >= indices_.size() || indices_[handle] == InvalidHandle) {
+        throw std::runtime_error("invalid sprite handle");
+    }
+    return indices_[handle];
+}
+
+void SpriteScene::markDirty(uint32_t index) {
+    dirtyPages_[index / PageSize] = true;
+    dirty_ = true;
+}
+
+void SpriteScene::RecordUpload(vk::CommandBuffer cmd, FrameAllocator& allocator) {
+    if (!dirty_) {
+        return;
+    }
+
+    // merge runs of dirty pages into one copy region each, pages past the end aren't drawn
+    uint32_t pageCount = (instances_.size() + PageSize - 1) / PageSize;
+    std::vector<vk::BufferCopy> regions;
+    size_t stagingSize = 0;
+    for (uint32_t page = 0; page < pageCount; page++) {
+        if (!dirtyPages_[page]) {
+            continue;
+        }
+        uint32_t first = page * PageSize;
+        while (page < pageCount && dirtyPages_[page]) {
+            page++;
+        }
+        uint32_t last = std::min<uint32_t>(page * PageSize, instances_.size());
+
+        vk::BufferCopy region;
+        region.setSrcOffset(stagingSize)
+              .setDstOffset(sizeof(SpriteInstance) * first)
+              .setSize(sizeof(SpriteInstance) * (last - first));
+        regions.push_back(region);
+        stagingSize += region.size;
+    }
+    dirtyPages_.assign(dirtyPages_.size(), false);
+    dirty_ = false;
+
+    if (regions.empty()) {
+        return;
+    }
+
+    auto staging = allocator.Allocate(stagingSize);
+    for (auto& region : regions) {
+        memcpy((char*)staging.map + region.srcOffset,
+               (char*)instances_.data() + region.dstOffset,
+               region.size);
+        region.srcOffset += staging.offset;
+    }
+
+    // earlier frames may still read the buffer, wait for them before overwriting it
+    cmd.pipelineBarrier(vk::PipelineStageFlagBits::eVertexInput, vk::PipelineStageFlagBits::eTransfer,
+                        {}, {}, {}, {});
+    cmd.copyBuffer(staging.buffer, buffer_->buffer, regions);
+
+    vk::BufferMemoryBarrier barrier;
+    barrier.setBuffer(buffer_->buffer)
+           .setOffset(0)
+           .setSize(VK_WHOLE_SIZE)
+           .setSrcAccessMask(vk::AccessFlagBits::eTransferWrite)
+           .setDstAccessMask(vk::AccessFlagBits::eVertexAttributeRead)
+           .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+           .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED);
+    cmd.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eVertexInput,
+                        {}, {}, barrier, {});
+}
+
+}
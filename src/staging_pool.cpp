@@ -0,0 +1,112 @@
+#include "toy2d/staging_pool.hpp"
+#include "toy2d/context.hpp"
+#include "toy2d/buffer.hpp"
+
+namespace toy2d {
+
+StagingPool::StagingPool(vk::DeviceSize size) {
+    buffer_.reset(new Buffer(vk::BufferUsageFlagBits::eTransferSrc,
+                             size,
+                             vk::MemoryPropertyFlagBits::eHostVisible|vk::MemoryPropertyFlagBits::eHostCoherent));
+}
+
+StagingPool::~StagingPool() {
+    regions_.clear();
+    retiredBuffers_.clear();
+    buffer_.reset();
+}
+
+vk::DeviceSize StagingPool::GetCapacity() const {
+    return buffer_->size;
+}
+
+StagingPool::Allocation StagingPool::Allocate(vk::DeviceSize size, vk::DeviceSize alignment) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    reclaim();
+
+    vk::DeviceSize offset;
+    if (!fit(size, alignment, offset)) {
+        grow(size);
+        offset = 0;
+    }
+    regions_.push_back({buffer_.get(), offset, offset + size, 0, false});
+
+    Allocation allocation;
+    allocation.buffer = buffer_->buffer;
+    allocation.offset = offset;
+    allocation.map = (char*)buffer_->map + offset;
+    return allocation;
+}
+
+void StagingPool::Release(const Allocation& allocation, uint64_t uploadValue) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // usually one of the latest allocations
+    for (auto it = regions_.rbegin(); it != regions_.rend(); it++) {
+        if (it->buffer->buffer == allocation.buffer && it->begin == allocation.offset && !it->released) {
+            it->released = true;
+            it->uploadValue = uploadValue;
+            return;
+        }
+    }
+}
+
+void StagingPool::reclaim() {
+    auto& uploads = Context::Instance().uploadQueue;
+    uint64_t completed = 0;
+    while (!regions_.empty() && regions_.front().released) {
+        auto value = regions_.front().uploadValue;
+        if (value > completed) {
+            completed = uploads->GetCompletedValue();
+            if (value > completed) {
+                break;
+            }
+        }
+        regions_.pop_front();
+    }
+
+    if (regions_.empty() || regions_.front().buffer == buffer_.get()) {
+        retiredBuffers_.clear();
+    }
+}
+
+bool StagingPool::fit(vk::DeviceSize size, vk::DeviceSize alignment, vk::DeviceSize& offset) {
+    // regions of the current buffer are the youngest ones, they occupy [tail, head)
+    // or, after wrapping around, [tail, end) and [0, head)
+    const Region* oldest = nullptr;
+    for (auto& region : regions_) {
+        if (region.buffer == buffer_.get()) {
+            oldest = &region;
+            break;
+        }
+    }
+    if (!oldest) {
+        offset = 0;
+        return size <= buffer_->size;
+    }
+
+    const Region& newest = regions_.back();
+    vk::DeviceSize tail = oldest->begin;
+    vk::DeviceSize head = (newest.end + alignment - 1) / alignment * alignment;
+    if (newest.begin >= oldest->begin) {
+        if (head + size <= buffer_->size) {
+            offset = head;
+            return true;
+        }
+        offset = 0;
+        return size <= tail;
+    }
+
+    offset = head;
+    return head + size <= tail;
+}
+
+void StagingPool::grow(vk::DeviceSize minSize) {
+    // the GPU may still read the old buffer, it is released by reclaim()
+    vk::DeviceSize newSize = std::max<vk::DeviceSize>(buffer_->size * 2, minSize);
+    retiredBuffers_.push_back(std::move(buffer_));
+    buffer_.reset(new Buffer(vk::BufferUsageFlagBits::eTransferSrc,
+                             newSize,
+                             vk::MemoryPropertyFlagBits::eHostVisible|vk::MemoryPropertyFlagBits::eHostCoherent));
+}
+
+}
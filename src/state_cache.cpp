@@ -0,0 +1,123 @@
+#include "toy2d/state_cache.hpp"
+
+namespace toy2d {
+
+StateCache::Stats& StateCache::Stats::operator+=(const Stats& o) {
+    drawCalls += o.drawCalls;
+    pipelineBinds += o.pipelineBinds;
+    elidedPipelineBinds += o.elidedPipelineBinds;
+    vertexBufferBinds += o.vertexBufferBinds;
+    elidedVertexBufferBinds += o.elidedVertexBufferBinds;
+    indexBufferBinds += o.indexBufferBinds;
+    elidedIndexBufferBinds += o.elidedIndexBufferBinds;
+    descriptorSetBinds += o.descriptorSetBinds;
+    elidedDescriptorSetBinds += o.elidedDescriptorSetBinds;
+    pushConstants += o.pushConstants;
+    elidedPushConstants += o.elidedPushConstants;
+    return *this;
+}
+
+void StateCache::Begin(vk::CommandBuffer cmd) {
+    cmd_ = cmd;
+    pipeline_ = nullptr;
+    layout_ = nullptr;
+    vertexBindings_.fill(VertexBinding{});
+    indexBuffer_ = nullptr;
+    indexOffset_ = 0;
+    indexType_ = vk::IndexType::eUint32;
+    invalidateLayoutState();
+    stats_ = Stats{};
+}
+
+void StateCache::invalidateLayoutState() {
+    descriptorSets_.fill(nullptr);
+    pushConstantsValid_.fill(false);
+}
+
+void StateCache::BindPipeline(vk::Pipeline pipeline, vk::PipelineLayout layout) {
+    if (layout != layout_) {
+        // sets and push constants are only kept across pipelines with a compatible layout,
+        // just forget them when the layout changes
+        invalidateLayoutState();
+        layout_ = layout;
+    }
+
+    if (pipeline == pipeline_) {
+        stats_.elidedPipelineBinds ++;
+        return;
+    }
+
+    cmd_.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline);
+    pipeline_ = pipeline;
+    stats_.pipelineBinds ++;
+}
+
+void StateCache::BindVertexBuffer(uint32_t binding, vk::Buffer buffer, vk::DeviceSize offset) {
+    auto& bound = vertexBindings_[binding];
+    if (bound.buffer == buffer && bound.offset == offset) {
+        stats_.elidedVertexBufferBinds ++;
+        return;
+    }
+
+    cmd_.bindVertexBuffers(binding, buffer, offset);
+    bound.buffer = buffer;
+    bound.offset = offset;
+    stats_.vertexBufferBinds ++;
+}
+
+void StateCache::BindIndexBuffer(vk::Buffer buffer, vk::DeviceSize offset, vk::IndexType type) {
+    if (indexBuffer_ == buffer && indexOffset_ == offset && indexType_ == type) {
+        stats_.elidedIndexBufferBinds ++;
+        return;
+    }
+
+    cmd_.bindIndexBuffer(buffer, offset, type);
+    indexBuffer_ = buffer;
+    indexOffset_ = offset;
+    indexType_ = type;
+    stats_.indexBufferBinds ++;
+}
+
+void StateCache::BindDescriptorSet(uint32_t set, vk::DescriptorSet descriptorSet) {
+    if (descriptorSets_[set] == descriptorSet) {
+        stats_.elidedDescriptorSetBinds ++;
+        return;
+    }
+
+    cmd_.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, layout_, set, descriptorSet, {});
+    descriptorSets_[set] = descriptorSet;
+    stats_.descriptorSetBinds ++;
+}
+
+void StateCache::PushConstants(vk::ShaderStageFlags stage, uint32_t offset, uint32_t size, const void* data) {
+    bool same = true;
+    for (uint32_t i = 0; i < size && same; i++) {
+        same = pushConstantsValid_[offset + i] && pushConstants_[offset + i] == ((const char*)data)[i];
+    }
+    if (same) {
+        stats_.elidedPushConstants ++;
+        return;
+    }
+
+    cmd_.pushConstants(layout_, stage, offset, size, data);
+    memcpy(pushConstants_.data() + offset, data, size);
+    std::fill(pushConstantsValid_.begin() + offset, pushConstantsValid_.begin() + offset + size, true);
+    stats_.pushConstants ++;
+}
+
+void StateCache::Draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance) {
+    cmd_.draw(vertexCount, instanceCount, firstVertex, firstInstance);
+    stats_.drawCalls ++;
+}
+
+void StateCache::DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance) {
+    cmd_.drawIndexed(indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
+    stats_.drawCalls ++;
+}
+
+void StateCache::DrawIndexedIndirect(vk::Buffer buffer, vk::DeviceSize offset, uint32_t drawCount, uint32_t stride) {
+    cmd_.drawIndexedIndirect(buffer, offset, drawCount, stride);
+    stats_.drawCalls ++;
+}
+
+}
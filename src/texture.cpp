@@ -1,69 +1,265 @@
 #include "toy2d/texture.hpp"
+#include <cmath>
+#include <filesystem>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "toy2d/stb_image.h"
 
 namespace toy2d {
 
-Texture::Texture(std::string_view filename) {
-    int w, h, channel;
-    stbi_uc* pixels = stbi_load(filename.data(), &w, &h, &channel, STBI_rgb_alpha);
-    size_t size = w * h * 4;
+namespace {
 
-    if (!pixels) {
-        throw std::runtime_error("image load failed");
+// stb decodes straight from the mapped file instead of reading it through stdio
+stbi_uc* decodeImage(const MappedFile& file, int& w, int& h) {
+    if (!file.IsOpen()) {
+        return nullptr;
     }
-    
-    init(pixels, w, h);
+    int channel;
+    return stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(file.Data()), static_cast<int>(file.Size()),
+                                 &w, &h, &channel, STBI_rgb_alpha);
+}
+
+stbi_uc* decodeImage(const std::string& filename, int& w, int& h) {
+    return decodeImage(MappedFile(filename), w, h);
+}
+
+// premultiplied RGBA8 pixels of an image file, mapped from the disk cache if it
+// has them. Fresh decodes are stored in the cache for the next run
+class ImagePixels final {
+public:
+    ImagePixels(const std::string& filename, const ImageDiskCache* cache) {
+        if (cache && (entry_ = cache->Find(filename)).IsOpen()) {
+            width_ = entry_.width;
+            height_ = entry_.height;
+            return;
+        }
+
+        int w, h;
+        decoded_ = decodeImage(filename, w, h);
+        if (!decoded_) {
+            throw std::runtime_error("image load failed");
+        }
+        width_ = w;
+        height_ = h;
+        PremultiplyAlpha(decoded_, size_t(width_) * height_);
+        if (cache) {
+            cache->Store(filename, decoded_, width_, height_);
+        }
+    }
+
+    ~ImagePixels() {
+        if (decoded_) {
+            stbi_image_free(decoded_);
+        }
+    }
+
+    ImagePixels(const ImagePixels&) = delete;
+    ImagePixels& operator=(const ImagePixels&) = delete;
+
+    // uploads only read the pixels, the mapping is never written
+    void* Data() const { return decoded_ ? decoded_ : const_cast<uint8_t*>(entry_.Pixels()); }
+    uint32_t Width() const { return width_; }
+    uint32_t Height() const { return height_; }
+
+private:
+    ImageDiskCache::Entry entry_;
+    stbi_uc* decoded_ = nullptr;
+    uint32_t width_ = 0;
+    uint32_t height_ = 0;
+};
+
+}
+
+Texture::Texture(void* data, unsigned int w, unsigned int h, bool mipmaps) {
+    init(data, w, h, nullptr, mipmaps);
+}
+
+Texture::Texture(void* data, uint32_t w, uint32_t h, UploadQueue& uploads, bool mipmaps) {
+    init(data, w, h, &uploads, mipmaps);
+}
+
+Texture::Texture(vk::Format format, uint32_t w, uint32_t h,
+                 const std::vector<CompressedImage::Level>& levels, const char* data) {
+    auto& ctx = Context::Instance();
+    format_ = format;
+    mipLevels_ = levels.size();
+    createResources(w, h, false, false);
+
+    // the levels are packed back to back, block sizes keep every offset aligned to its block
+    size_t size = 0;
+    for (auto& level : levels) {
+        size += level.size;
+    }
+    auto staging = ctx.stagingPool->Allocate(size);
+
+    std::vector<vk::BufferImageCopy> regions;
+    vk::DeviceSize offset = 0;
+    for (uint32_t i = 0; i < levels.size(); i++) {
+        auto& level = levels[i];
+        memcpy((char*)staging.map + offset, data + level.offset, level.size);
 
-    stbi_image_free(pixels);
+        vk::ImageSubresourceLayers subsource;
+        subsource.setAspectMask(vk::ImageAspectFlagBits::eColor)
+                 .setBaseArrayLayer(0)
+                 .setMipLevel(i)
+                 .setLayerCount(1);
+        vk::BufferImageCopy region;
+        region.setBufferImageHeight(0)
+              .setBufferOffset(staging.offset + offset)
+              .setImageOffset(0)
+              .setImageExtent({level.width, level.height, 1})
+              .setBufferRowLength(0)
+              .setImageSubresource(subsource);
+        regions.push_back(region);
+        offset += level.size;
+    }
+
+    ctx.commandManager->ExecuteCmd(ctx.graphicsQueue,
+        [&](vk::CommandBuffer cmdBuf){
+            transitionImageLayoutFromUndefine2Dst(cmdBuf);
+            cmdBuf.copyBufferToImage(staging.buffer, image, vk::ImageLayout::eTransferDstOptimal, regions);
+            transitionImageLayoutFromDst2Optimal(cmdBuf, vk::PipelineStageFlagBits::eFragmentShader,
+                                                 vk::AccessFlagBits::eShaderRead);
+        });
+    ctx.stagingPool->Release(staging);
 }
 
-Texture::Texture(void* data, unsigned int w, unsigned int h) {
-    init(data, w, h);
+Texture::Texture(Texture& atlasPage, const Rect& uv): uv(uv), atlasPage_(&atlasPage) {
+    image = atlasPage.image;
+    memory = atlasPage.memory;
+    view = atlasPage.view;
+    set = atlasPage.set;
+    id = atlasPage.id;
+    bindlessIndex = atlasPage.bindlessIndex;
 }
 
-void Texture::init(void* data, uint32_t w, uint32_t h) {
-    const uint32_t size = w * h * 4;
-    std::unique_ptr<Buffer> buffer(new Buffer(vk::BufferUsageFlagBits::eTransferSrc,
-                                   size,
-                                   vk::MemoryPropertyFlagBits::eHostCoherent|vk::MemoryPropertyFlagBits::eHostVisible));
-    memcpy(buffer->map, data, size);
+Texture::Texture(uint32_t w, uint32_t h, bool shared, bool mipmaps) {
+    createResources(w, h, shared, mipmaps);
+}
 
-    createImage(w, h);
+void Texture::init(void* data, uint32_t w, uint32_t h, UploadQueue* uploads, bool mipmaps) {
+    auto& ctx = Context::Instance();
+    bool shared = uploads && ctx.queueInfo.transferIndex.value() != ctx.queueInfo.graphicsIndex.value();
+    createResources(w, h, shared, mipmaps);
+
+    StagingPool::Allocation staging;
+    if (data) {
+        const uint32_t size = w * h * 4;
+        staging = ctx.stagingPool->Allocate(size);
+        memcpy(staging.map, data, size);
+    }
+
+    if (uploads) {
+        // the transfer queue has no shader stages, the renderer waits on the
+        // upload's timeline value before sampling instead
+        auto cmdBuf = uploads->GetCommandBuffer();
+        transitionImageLayoutFromUndefine2Dst(cmdBuf);
+        transformData2Image(cmdBuf, staging.buffer, w, h, staging.offset);
+        if (mipLevels_ > 1) {
+            generateMipmaps(cmdBuf, w, h, vk::PipelineStageFlagBits::eBottomOfPipe, {});
+        } else {
+            transitionImageLayoutFromDst2Optimal(cmdBuf, vk::PipelineStageFlagBits::eBottomOfPipe, {});
+        }
+        uploadValue_ = uploads->GetBatchValue();
+        ctx.stagingPool->Release(staging, uploadValue_);
+    } else {
+        ctx.commandManager->ExecuteCmd(ctx.graphicsQueue,
+            [&](vk::CommandBuffer cmdBuf){
+                transitionImageLayoutFromUndefine2Dst(cmdBuf);
+                if (data) {
+                    transformData2Image(cmdBuf, staging.buffer, w, h, staging.offset);
+                } else {
+                    clearImage(cmdBuf);
+                }
+                if (mipLevels_ > 1) {
+                    generateMipmaps(cmdBuf, w, h, vk::PipelineStageFlagBits::eFragmentShader,
+                                    vk::AccessFlagBits::eShaderRead);
+                } else {
+                    transitionImageLayoutFromDst2Optimal(cmdBuf, vk::PipelineStageFlagBits::eFragmentShader,
+                                                         vk::AccessFlagBits::eShaderRead);
+                }
+            });
+        if (data) {
+            ctx.stagingPool->Release(staging);
+        }
+    }
+}
+
+void Texture::createResources(uint32_t w, uint32_t h, bool shared, bool mipmaps) {
+    // mips are blitted, which the transfer queue can't do. Images shared with it upload level 0 only
+    if (mipmaps && !shared) {
+        mipLevels_ = static_cast<uint32_t>(std::floor(std::log2(std::max(w, h)))) + 1;
+    }
+    createImage(w, h, shared);
     allocMemory();
     Context::Instance().device.bindImageMemory(image, memory, 0);
 
-    transitionImageLayoutFromUndefine2Dst();
-    transformData2Image(*buffer, w, h);
-    transitionImageLayoutFromDst2Optimal();
-
     createImageView();
 
     set = DescriptorSetManager::Instance().AllocImageSet();
 
     updateDescriptorSet();
+
+    if (Context::Instance().bindlessInfo.supported) {
+        bindlessIndex = DescriptorSetManager::Instance().AllocTextureIndex(view, Context::Instance().sampler);
+    }
+}
+
+bool Texture::IsReady() const {
+    uint64_t value = uploadValue_.load(std::memory_order_relaxed);
+    if (value == 0) {
+        return true;
+    }
+    if (!Context::Instance().uploadQueue->IsComplete(value)) {
+        return false;
+    }
+    uploadValue_.store(0, std::memory_order_relaxed);
+    return true;
+}
+
+void Texture::WaitReady() {
+    uint64_t value = uploadValue_.load(std::memory_order_relaxed);
+    if (value != 0) {
+        Context::Instance().uploadQueue->Wait(value);
+        uploadValue_.store(0, std::memory_order_relaxed);
+    }
 }
 
 Texture::~Texture() {
+    if (atlasPage_) {
+        return;
+    }
+
     auto& device = Context::Instance().device;
     DescriptorSetManager::Instance().FreeImageSet(set);
+    if (Context::Instance().bindlessInfo.supported) {
+        DescriptorSetManager::Instance().FreeTextureIndex(bindlessIndex);
+    }
     device.destroyImageView(view);
     device.freeMemory(memory);
     device.destroyImage(image);
 }
 
-void Texture::createImage(uint32_t w, uint32_t h) {
+void Texture::createImage(uint32_t w, uint32_t h, bool shared) {
+    auto& queueInfo = Context::Instance().queueInfo;
+    std::array<uint32_t, 2> families = {queueInfo.graphicsIndex.value(), queueInfo.transferIndex.value()};
+
     vk::ImageCreateInfo createInfo;
     createInfo.setImageType(vk::ImageType::e2D)
               .setArrayLayers(1)
-              .setMipLevels(1)
+              .setMipLevels(mipLevels_)
               .setExtent({w, h, 1})
-              .setFormat(vk::Format::eR8G8B8A8Srgb)
+              .setFormat(format_)
               .setTiling(vk::ImageTiling::eOptimal)
               .setInitialLayout(vk::ImageLayout::eUndefined)
-              .setUsage(vk::ImageUsageFlagBits::eTransferDst|vk::ImageUsageFlagBits::eSampled)
+              .setUsage(vk::ImageUsageFlagBits::eTransferSrc|vk::ImageUsageFlagBits::eTransferDst|vk::ImageUsageFlagBits::eSampled)
               .setSamples(vk::SampleCountFlagBits::e1);
+    // written on the transfer queue and sampled on the graphics queue, concurrent
+    // sharing saves the queue family ownership transfer
+    if (shared) {
+        createInfo.setSharingMode(vk::SharingMode::eConcurrent)
+                  .setQueueFamilyIndices(families);
+    }
     image = Context::Instance().device.createImage(createInfo);
 }
 
@@ -80,70 +276,111 @@ void Texture::allocMemory() {
     memory = device.allocateMemory(allocInfo);
 }
 
-void Texture::transformData2Image(Buffer& buffer, uint32_t w, uint32_t h) {
-    Context::Instance().commandManager->ExecuteCmd(Context::Instance().graphicsQueue,
-        [&](vk::CommandBuffer cmdBuf){
-            vk::BufferImageCopy region;
-            vk::ImageSubresourceLayers subsource;
-            subsource.setAspectMask(vk::ImageAspectFlagBits::eColor)
-                     .setBaseArrayLayer(0)
-                     .setMipLevel(0)
-                     .setLayerCount(1);
-            region.setBufferImageHeight(0)
-                  .setBufferOffset(0)
-                  .setImageOffset(0)
-                  .setImageExtent({w, h, 1})
-                  .setBufferRowLength(0)
-                  .setImageSubresource(subsource);
-            cmdBuf.copyBufferToImage(buffer.buffer, image,
-                                     vk::ImageLayout::eTransferDstOptimal,
-                                     region);
-        });
+void Texture::transformData2Image(vk::CommandBuffer cmdBuf, vk::Buffer buffer, uint32_t w, uint32_t h, vk::DeviceSize offset) {
+    vk::BufferImageCopy region;
+    vk::ImageSubresourceLayers subsource;
+    subsource.setAspectMask(vk::ImageAspectFlagBits::eColor)
+             .setBaseArrayLayer(0)
+             .setMipLevel(0)
+             .setLayerCount(1);
+    region.setBufferImageHeight(0)
+          .setBufferOffset(offset)
+          .setImageOffset(0)
+          .setImageExtent({w, h, 1})
+          .setBufferRowLength(0)
+          .setImageSubresource(subsource);
+    cmdBuf.copyBufferToImage(buffer, image,
+                             vk::ImageLayout::eTransferDstOptimal,
+                             region);
 }
 
-void Texture::transitionImageLayoutFromUndefine2Dst() {
-    Context::Instance().commandManager->ExecuteCmd(Context::Instance().graphicsQueue,
-        [&](vk::CommandBuffer cmdBuf){
-            vk::ImageMemoryBarrier barrier;
-            vk::ImageSubresourceRange range;
-            range.setLayerCount(1)
-                 .setBaseArrayLayer(0)
-                 .setLevelCount(1)
-                 .setBaseMipLevel(0)
-                 .setAspectMask(vk::ImageAspectFlagBits::eColor);
-            barrier.setImage(image)
-                   .setOldLayout(vk::ImageLayout::eUndefined)
-                   .setNewLayout(vk::ImageLayout::eTransferDstOptimal)
-                   .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
-                   .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
-                   .setDstAccessMask((vk::AccessFlagBits::eTransferWrite))
-                   .setSubresourceRange(range);
-            cmdBuf.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer,
-                                   {}, {}, nullptr, barrier);
-        });
+void Texture::clearImage(vk::CommandBuffer cmdBuf) {
+    vk::ImageSubresourceRange range;
+    range.setLayerCount(1)
+         .setBaseArrayLayer(0)
+         .setLevelCount(mipLevels_)
+         .setBaseMipLevel(0)
+         .setAspectMask(vk::ImageAspectFlagBits::eColor);
+    vk::ClearColorValue color(std::array<float, 4>{0, 0, 0, 0});
+    cmdBuf.clearColorImage(image, vk::ImageLayout::eTransferDstOptimal, color, range);
 }
 
-void Texture::transitionImageLayoutFromDst2Optimal() {
-    Context::Instance().commandManager->ExecuteCmd(Context::Instance().graphicsQueue,
-        [&](vk::CommandBuffer cmdBuf){
-            vk::ImageMemoryBarrier barrier;
-            vk::ImageSubresourceRange range;
-            range.setLayerCount(1)
-                 .setBaseArrayLayer(0)
-                 .setLevelCount(1)
-                 .setBaseMipLevel(0)
-                 .setAspectMask(vk::ImageAspectFlagBits::eColor);
-            barrier.setImage(image)
-                   .setOldLayout(vk::ImageLayout::eTransferDstOptimal)
-                   .setNewLayout(vk::ImageLayout::eShaderReadOnlyOptimal)
-                   .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
-                   .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
-                   .setSrcAccessMask((vk::AccessFlagBits::eTransferWrite))
-                   .setDstAccessMask((vk::AccessFlagBits::eShaderRead))
-                   .setSubresourceRange(range);
-            cmdBuf.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eFragmentShader,
-                                   {}, {}, nullptr, barrier);
-        });
+vk::ImageMemoryBarrier Texture::layoutBarrier(vk::ImageLayout oldLayout, vk::ImageLayout newLayout,
+                                              vk::AccessFlags srcAccess, vk::AccessFlags dstAccess,
+                                              uint32_t baseMip, uint32_t mipCount) {
+    vk::ImageMemoryBarrier barrier;
+    vk::ImageSubresourceRange range;
+    range.setLayerCount(1)
+         .setBaseArrayLayer(0)
+         .setLevelCount(mipCount)
+         .setBaseMipLevel(baseMip)
+         .setAspectMask(vk::ImageAspectFlagBits::eColor);
+    barrier.setImage(image)
+           .setOldLayout(oldLayout)
+           .setNewLayout(newLayout)
+           .setDstQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+           .setSrcQueueFamilyIndex(VK_QUEUE_FAMILY_IGNORED)
+           .setSrcAccessMask(srcAccess)
+           .setDstAccessMask(dstAccess)
+           .setSubresourceRange(range);
+    return barrier;
+}
+
+void Texture::transitionImageLayoutFromUndefine2Dst(vk::CommandBuffer cmdBuf) {
+    auto barrier = layoutBarrier(vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal,
+                                 {}, vk::AccessFlagBits::eTransferWrite);
+    cmdBuf.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer,
+                           {}, {}, nullptr, barrier);
+}
+
+void Texture::transitionImageLayoutFromDst2Optimal(vk::CommandBuffer cmdBuf, vk::PipelineStageFlags dstStage, vk::AccessFlags dstAccess) {
+    auto barrier = layoutBarrier(vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal,
+                                 vk::AccessFlagBits::eTransferWrite, dstAccess);
+    cmdBuf.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, dstStage,
+                           {}, {}, nullptr, barrier);
+}
+
+void Texture::generateMipmaps(vk::CommandBuffer cmdBuf, uint32_t w, uint32_t h, vk::PipelineStageFlags dstStage, vk::AccessFlags dstAccess) {
+    // every level is blitted from the one above it, which becomes a transfer
+    // source for that and is handed to the shaders right after
+    int32_t mipW = w, mipH = h;
+    for (uint32_t i = 1; i < mipLevels_; i++) {
+        auto barrier = layoutBarrier(vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eTransferSrcOptimal,
+                                     vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eTransferRead, i - 1, 1);
+        cmdBuf.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer,
+                               {}, {}, nullptr, barrier);
+
+        int32_t nextW = std::max(mipW / 2, 1);
+        int32_t nextH = std::max(mipH / 2, 1);
+        vk::ImageSubresourceLayers srcSubsource;
+        srcSubsource.setAspectMask(vk::ImageAspectFlagBits::eColor)
+                    .setBaseArrayLayer(0)
+                    .setMipLevel(i - 1)
+                    .setLayerCount(1);
+        vk::ImageSubresourceLayers dstSubsource = srcSubsource;
+        dstSubsource.setMipLevel(i);
+        vk::ImageBlit blit;
+        blit.setSrcSubresource(srcSubsource)
+            .setSrcOffsets({vk::Offset3D{0, 0, 0}, vk::Offset3D{mipW, mipH, 1}})
+            .setDstSubresource(dstSubsource)
+            .setDstOffsets({vk::Offset3D{0, 0, 0}, vk::Offset3D{nextW, nextH, 1}});
+        cmdBuf.blitImage(image, vk::ImageLayout::eTransferSrcOptimal,
+                         image, vk::ImageLayout::eTransferDstOptimal,
+                         blit, vk::Filter::eLinear);
+
+        barrier = layoutBarrier(vk::ImageLayout::eTransferSrcOptimal, vk::ImageLayout::eShaderReadOnlyOptimal,
+                                vk::AccessFlagBits::eTransferRead, dstAccess, i - 1, 1);
+        cmdBuf.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, dstStage,
+                               {}, {}, nullptr, barrier);
+
+        mipW = nextW;
+        mipH = nextH;
+    }
+
+    auto barrier = layoutBarrier(vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal,
+                                 vk::AccessFlagBits::eTransferWrite, dstAccess, mipLevels_ - 1, 1);
+    cmdBuf.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, dstStage,
+                           {}, {}, nullptr, barrier);
 }
 
 void Texture::createImageView() {
@@ -153,12 +390,12 @@ void Texture::createImageView() {
     range.setAspectMask(vk::ImageAspectFlagBits::eColor)
          .setBaseArrayLayer(0)
          .setLayerCount(1)
-         .setLevelCount(1)
+         .setLevelCount(mipLevels_)
          .setBaseMipLevel(0);
     createInfo.setImage(image)
               .setViewType(vk::ImageViewType::e2D)
               .setComponents(mapping)
-              .setFormat(vk::Format::eR8G8B8A8Srgb)
+              .setFormat(format_)
               .setSubresourceRange(range);
     view = Context::Instance().device.createImageView(createInfo);
 }
@@ -181,28 +418,451 @@ void Texture::updateDescriptorSet() {
 std::unique_ptr<TextureManager> TextureManager::instance_ = nullptr;
 
 Texture* TextureManager::Load(const std::string& filename) {
-    datas_.push_back(std::unique_ptr<Texture>(new Texture(filename)));
+    auto key = cacheKey(filename);
+    if (auto texture = acquireCached(key)) {
+        return texture;
+    }
+
+    auto texture = loadFile(filename);
+    addToCache(key, texture);
+    return texture;
+}
+
+Texture* TextureManager::loadFile(const std::string& filename) {
+    if (IsCompressedImageFile(filename)) {
+        return loadCompressed(filename);
+    }
+
+    ImagePixels pixels(filename, diskCache_.get());
+    uint32_t w = pixels.Width(), h = pixels.Height();
+    if (atlasMode_ && w <= MaxAtlasImageSize && h <= MaxAtlasImageSize) {
+        auto& ctx = Context::Instance();
+        const uint32_t size = w * h * 4;
+        auto staging = ctx.stagingPool->Allocate(size);
+        memcpy(staging.map, pixels.Data(), size);
+        std::vector<AtlasCopy> copies;
+        auto texture = loadIntoAtlas(w, h, staging.offset, copies);
+        copyToAtlas(staging.buffer, copies);
+        ctx.stagingPool->Release(staging);
+        return texture;
+    }
+    return Create(pixels.Data(), w, h);
+}
+
+Texture* TextureManager::LoadAsync(const std::string& filename) {
+    auto key = cacheKey(filename);
+    if (auto texture = acquireCached(key)) {
+        return texture;
+    }
+
+    auto& uploads = Context::Instance().uploadQueue;
+    if (!uploads || IsCompressedImageFile(filename)) {
+        auto texture = loadFile(filename);
+        addToCache(key, texture);
+        return texture;
+    }
+
+    ImagePixels pixels(filename, diskCache_.get());
+    datas_.push_back(std::unique_ptr<Texture>(new Texture(pixels.Data(), pixels.Width(), pixels.Height(),
+                                                          *uploads, mipmaps_)));
+    datas_.back()->id = nextId_++;
+    addToCache(key, datas_.back().get());
+    return datas_.back().get();
+}
+
+std::vector<Texture*> TextureManager::LoadTextures(const std::vector<std::string>& filenames, bool async) {
+    // cached files are taken from the cache and compressed files need no decoding,
+    // they are loaded one by one. Files listed twice are decoded once
+    std::vector<Texture*> textures(filenames.size());
+    std::vector<std::string> keys(filenames.size());
+    std::vector<std::string> decodedFiles;
+    std::vector<size_t> decodedSlots;
+    std::vector<size_t> duplicateSlots;
+    std::unordered_map<std::string, size_t> pending;
+    for (size_t i = 0; i < filenames.size(); i++) {
+        keys[i] = cacheKey(filenames[i]);
+        if ((textures[i] = acquireCached(keys[i]))) {
+            continue;
+        }
+        if (IsCompressedImageFile(filenames[i])) {
+            textures[i] = loadCompressed(filenames[i]);
+            addToCache(keys[i], textures[i]);
+        } else if (pending.count(keys[i])) {
+            duplicateSlots.push_back(i);
+        } else {
+            pending[keys[i]] = i;
+            decodedFiles.push_back(filenames[i]);
+            decodedSlots.push_back(i);
+        }
+    }
+
+    auto decoded = loadDecoded(decodedFiles, async);
+    for (size_t i = 0; i < decoded.size(); i++) {
+        textures[decodedSlots[i]] = decoded[i];
+        addToCache(keys[decodedSlots[i]], decoded[i]);
+    }
+    for (auto i : duplicateSlots) {
+        textures[i] = acquireCached(keys[i]);
+    }
+    return textures;
+}
+
+std::vector<Texture*> TextureManager::loadDecoded(const std::vector<std::string>& filenames, bool async) {
+    struct ImageInfo {
+        int w = 0;
+        int h = 0;
+        vk::DeviceSize offset = 0;
+    };
+    std::vector<ImageInfo> infos(filenames.size());
+    auto& pool = getDecodePool();
+
+    // read the headers first, so every image knows its place in the staging buffer
+    // and the decoders can write there directly. The files stay mapped for decoding,
+    // images found in the disk cache are copied from their entry instead
+    std::vector<MappedFile> files(filenames.size());
+    std::vector<ImageDiskCache::Entry> cached(filenames.size());
+    auto diskCache = diskCache_.get();
+    for (size_t i = 0; i < filenames.size(); i++) {
+        pool.Enqueue([&, i](uint32_t) {
+            if (diskCache && (cached[i] = diskCache->Find(filenames[i])).IsOpen()) {
+                infos[i].w = cached[i].width;
+                infos[i].h = cached[i].height;
+                return;
+            }
+            int channel;
+            files[i] = MappedFile(filenames[i]);
+            if (!files[i].IsOpen() ||
+                !stbi_info_from_memory(reinterpret_cast<const stbi_uc*>(files[i].Data()), static_cast<int>(files[i].Size()),
+                                       &infos[i].w, &infos[i].h, &channel)) {
+                throw std::runtime_error("image load failed");
+            }
+        });
+    }
+    pool.Wait();
+
+    vk::DeviceSize size = 0;
+    for (auto& info : infos) {
+        info.offset = size;
+        size += static_cast<vk::DeviceSize>(info.w) * info.h * 4;
+    }
+    if (size == 0) {
+        return {};
+    }
+    auto& ctx = Context::Instance();
+    auto staging = ctx.stagingPool->Allocate(size);
+    auto stagingData = static_cast<uint8_t*>(staging.map);
+
+    for (size_t i = 0; i < filenames.size(); i++) {
+        pool.Enqueue([&, i](uint32_t) {
+            size_t size = static_cast<size_t>(infos[i].w) * infos[i].h * 4;
+            if (cached[i].IsOpen()) {
+                memcpy(stagingData + infos[i].offset, cached[i].Pixels(), size);
+                return;
+            }
+            int w, h;
+            stbi_uc* pixels = decodeImage(files[i], w, h);
+            if (!pixels) {
+                throw std::runtime_error("image load failed");
+            }
+            // done on the decoded copy, staging memory may be uncached and slow to read back
+            PremultiplyAlpha(pixels, size / 4);
+            memcpy(stagingData + infos[i].offset, pixels, size);
+            if (diskCache) {
+                diskCache->Store(filenames[i], pixels, infos[i].w, infos[i].h);
+            }
+            stbi_image_free(pixels);
+        });
+    }
+    try {
+        pool.Wait();
+    } catch (...) {
+        ctx.stagingPool->Release(staging);
+        throw;
+    }
+
+    UploadQueue* uploads = async ? ctx.uploadQueue.get() : nullptr;
+    bool shared = uploads && ctx.queueInfo.transferIndex.value() != ctx.queueInfo.graphicsIndex.value();
+
+    std::vector<Texture*> textures(filenames.size());
+    std::vector<size_t> uploaded;
+    std::vector<AtlasCopy> atlasCopies;
+    for (size_t i = 0; i < filenames.size(); i++) {
+        uint32_t w = infos[i].w, h = infos[i].h;
+        if (atlasMode_ && w <= MaxAtlasImageSize && h <= MaxAtlasImageSize) {
+            textures[i] = loadIntoAtlas(w, h, staging.offset + infos[i].offset, atlasCopies);
+            continue;
+        }
+        datas_.push_back(std::unique_ptr<Texture>(new Texture(w, h, shared, mipmaps_)));
+        datas_.back()->id = nextId_++;
+        textures[i] = datas_.back().get();
+        uploaded.push_back(i);
+    }
+    copyToAtlas(staging.buffer, atlasCopies);
+    if (uploaded.empty()) {
+        ctx.stagingPool->Release(staging);
+        return textures;
+    }
+
+    // every image goes through the same transitions, one barrier call each for all of them.
+    // Mipmapped images are finished by their blits instead
+    auto record = [&](vk::CommandBuffer cmdBuf, vk::PipelineStageFlags dstStage, vk::AccessFlags dstAccess) {
+        std::vector<vk::ImageMemoryBarrier> barriers;
+        for (auto i : uploaded) {
+            barriers.push_back(textures[i]->layoutBarrier(vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal,
+                                                          {}, vk::AccessFlagBits::eTransferWrite));
+        }
+        cmdBuf.pipelineBarrier(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer,
+                               {}, {}, nullptr, barriers);
+
+        for (auto i : uploaded) {
+            textures[i]->transformData2Image(cmdBuf, staging.buffer, infos[i].w, infos[i].h, staging.offset + infos[i].offset);
+        }
+
+        barriers.clear();
+        for (auto i : uploaded) {
+            if (textures[i]->mipLevels_ > 1) {
+                textures[i]->generateMipmaps(cmdBuf, infos[i].w, infos[i].h, dstStage, dstAccess);
+                continue;
+            }
+            barriers.push_back(textures[i]->layoutBarrier(vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal,
+                                                          vk::AccessFlagBits::eTransferWrite, dstAccess));
+        }
+        if (!barriers.empty()) {
+            cmdBuf.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, dstStage,
+                                   {}, {}, nullptr, barriers);
+        }
+    };
+
+    if (uploads) {
+        record(uploads->GetCommandBuffer(), vk::PipelineStageFlagBits::eBottomOfPipe, {});
+        for (auto i : uploaded) {
+            textures[i]->uploadValue_ = uploads->GetBatchValue();
+        }
+        ctx.stagingPool->Release(staging, uploads->GetBatchValue());
+        uploads->Submit();
+    } else {
+        ctx.commandManager->ExecuteCmd(ctx.graphicsQueue,
+            [&](vk::CommandBuffer cmdBuf){
+                record(cmdBuf, vk::PipelineStageFlagBits::eFragmentShader, vk::AccessFlagBits::eShaderRead);
+            });
+        ctx.stagingPool->Release(staging);
+    }
+
+    return textures;
+}
+
+void TextureManager::SetMipmaps(bool enable) {
+    // levels are blitted from each other with linear filtering, the format has to
+    // support being blit source and destination besides being sampled
+    auto properties = Context::Instance().phyDevice.getFormatProperties(vk::Format::eR8G8B8A8Srgb);
+    auto required = vk::FormatFeatureFlagBits::eBlitSrc|vk::FormatFeatureFlagBits::eBlitDst;
+    mipmaps_ = enable && IsFormatSupported(vk::Format::eR8G8B8A8Srgb) &&
+               (properties.optimalTilingFeatures & required) == required;
+}
+
+void TextureManager::SetDiskCache(const std::string& directory) {
+    if (directory.empty()) {
+        diskCache_.reset();
+    } else {
+        diskCache_ = std::make_unique<ImageDiskCache>(directory);
+    }
+}
+
+WorkerPool& TextureManager::getDecodePool() {
+    if (!decodePool_) {
+        decodePool_ = std::make_unique<WorkerPool>(std::max(1u, std::thread::hardware_concurrency()));
+    }
+    return *decodePool_;
+}
+
+Texture* TextureManager::loadCompressed(const std::string& filename) {
+    auto compressed = LoadCompressedImage(filename);
+    if (!IsFormatSupported(compressed.format)) {
+        throw std::runtime_error("compressed texture format not supported by the device");
+    }
+
+    datas_.push_back(std::unique_ptr<Texture>(new Texture(compressed.format, compressed.width, compressed.height,
+                                                          compressed.levels, compressed.file.Data())));
+    datas_.back()->id = nextId_++;
+    return datas_.back().get();
+}
+
+Texture* TextureManager::Load(const AssetArchive& archive, const std::string& name) {
+    auto key = cacheKey(archive.GetFilename()) + "#" + name;
+    if (auto texture = acquireCached(key)) {
+        return texture;
+    }
+
+    auto entry = archive.Find(name);
+    if (!entry) {
+        throw std::runtime_error("image not found in asset archive");
+    }
+    auto format = static_cast<vk::Format>(entry->format);
+    if (!IsFormatSupported(format)) {
+        throw std::runtime_error("archived texture format not supported by the device");
+    }
+
+    std::vector<CompressedImage::Level> levels;
+    size_t offset = 0;
+    for (uint32_t i = 0; i < entry->levelCount; i++) {
+        CompressedImage::Level level;
+        level.width = std::max(1u, entry->width >> i);
+        level.height = std::max(1u, entry->height >> i);
+        level.offset = offset;
+        level.size = ImageLevelSize(format, level.width, level.height);
+        if (level.size == 0 || level.size > entry->dataSize - offset) {
+            throw std::runtime_error("asset archive is corrupted");
+        }
+        levels.push_back(level);
+        offset += level.size;
+    }
+
+    // the pixels go from the mapped archive straight into staging memory
+    datas_.push_back(std::unique_ptr<Texture>(new Texture(format, entry->width, entry->height,
+                                                          levels, archive.GetData(*entry))));
+    datas_.back()->id = nextId_++;
+    addToCache(key, datas_.back().get());
+    return datas_.back().get();
+}
+
+bool TextureManager::IsFormatSupported(vk::Format format) {
+    auto properties = Context::Instance().phyDevice.getFormatProperties(format);
+    auto required = vk::FormatFeatureFlagBits::eSampledImage|vk::FormatFeatureFlagBits::eSampledImageFilterLinear;
+    return (properties.optimalTilingFeatures & required) == required;
+}
+
+Texture* TextureManager::loadIntoAtlas(uint32_t w, uint32_t h, vk::DeviceSize offset, std::vector<AtlasCopy>& copies) {
+    uint32_t x = 0, y = 0;
+    AtlasPage* page = nullptr;
+    for (auto& p : atlasPages_) {
+        if (p.packer.Pack(w + AtlasPadding * 2, h + AtlasPadding * 2, x, y)) {
+            page = &p;
+            break;
+        }
+    }
+    if (!page) {
+        AtlasPage newPage{std::unique_ptr<Texture>(new Texture(nullptr, AtlasPageSize, AtlasPageSize)),
+                          SkylinePacker(AtlasPageSize, AtlasPageSize)};
+        newPage.texture->id = nextId_++;
+        newPage.packer.Pack(w + AtlasPadding * 2, h + AtlasPadding * 2, x, y);
+        atlasPages_.push_back(std::move(newPage));
+        page = &atlasPages_.back();
+    }
+
+    x += AtlasPadding;
+    y += AtlasPadding;
+    vk::ImageSubresourceLayers subsource;
+    subsource.setAspectMask(vk::ImageAspectFlagBits::eColor)
+             .setBaseArrayLayer(0)
+             .setMipLevel(0)
+             .setLayerCount(1);
+    vk::BufferImageCopy region;
+    region.setBufferImageHeight(0)
+          .setBufferOffset(offset)
+          .setImageOffset({static_cast<int32_t>(x), static_cast<int32_t>(y), 0})
+          .setImageExtent({w, h, 1})
+          .setBufferRowLength(0)
+          .setImageSubresource(subsource);
+    copies.push_back({page->texture.get(), region});
+
+    Rect uv{Vec{static_cast<float>(x) / AtlasPageSize, static_cast<float>(y) / AtlasPageSize},
+            Size{static_cast<float>(w) / AtlasPageSize, static_cast<float>(h) / AtlasPageSize}};
+    datas_.push_back(std::unique_ptr<Texture>(new Texture(*page->texture, uv)));
     return datas_.back().get();
 }
 
+void TextureManager::copyToAtlas(vk::Buffer buffer, const std::vector<AtlasCopy>& copies) {
+    if (copies.empty()) {
+        return;
+    }
+    std::vector<Texture*> pages;
+    for (auto& copy : copies) {
+        if (std::find(pages.begin(), pages.end(), copy.page) == pages.end()) {
+            pages.push_back(copy.page);
+        }
+    }
+
+    // other regions of the pages may be sampled by frames in flight on the graphics
+    // queue, the barriers order the copies after them. ExecuteCmd still idles the
+    // device afterwards, so a load records all of its copies into one submit
+    auto& ctx = Context::Instance();
+    ctx.commandManager->ExecuteCmd(ctx.graphicsQueue,
+        [&](vk::CommandBuffer cmdBuf){
+            std::vector<vk::ImageMemoryBarrier> barriers;
+            for (auto page : pages) {
+                barriers.push_back(page->layoutBarrier(vk::ImageLayout::eShaderReadOnlyOptimal, vk::ImageLayout::eTransferDstOptimal,
+                                                       vk::AccessFlagBits::eShaderRead, vk::AccessFlagBits::eTransferWrite));
+            }
+            cmdBuf.pipelineBarrier(vk::PipelineStageFlagBits::eFragmentShader, vk::PipelineStageFlagBits::eTransfer,
+                                   {}, {}, nullptr, barriers);
+
+            for (auto& copy : copies) {
+                cmdBuf.copyBufferToImage(buffer, copy.page->image, vk::ImageLayout::eTransferDstOptimal, copy.region);
+            }
+
+            barriers.clear();
+            for (auto page : pages) {
+                barriers.push_back(page->layoutBarrier(vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal,
+                                                       vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderRead));
+            }
+            cmdBuf.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eFragmentShader,
+                                   {}, {}, nullptr, barriers);
+        });
+}
+
 Texture* TextureManager::Create(void* data, uint32_t w, uint32_t h) {
-    datas_.push_back(std::unique_ptr<Texture>(new Texture(data, w, h)));
+    datas_.push_back(std::unique_ptr<Texture>(new Texture(data, w, h, mipmaps_)));
+    datas_.back()->id = nextId_++;
     return datas_.back().get();
 }
 
 void TextureManager::Clear() {
+    cache_.clear();
     datas_.clear();
+    atlasPages_.clear();
+}
+
+std::string TextureManager::cacheKey(const std::string& filename) {
+    // different spellings of one file share an entry, files that don't exist keep
+    // their name and fail when they're loaded
+    std::error_code error;
+    auto path = std::filesystem::weakly_canonical(filename, error);
+    return error ? filename : path.string();
+}
+
+Texture* TextureManager::acquireCached(const std::string& key) {
+    auto it = cache_.find(key);
+    if (it == cache_.end()) {
+        return nullptr;
+    }
+    it->second->refCount_++;
+    return it->second;
+}
+
+void TextureManager::addToCache(const std::string& key, Texture* texture) {
+    texture->cacheKey_ = key;
+    texture->refCount_ = 1;
+    cache_[key] = texture;
 }
 
 void TextureManager::Destroy(Texture* texture) {
+    if (!texture->cacheKey_.empty()) {
+        if (--texture->refCount_ > 0) {
+            return;
+        }
+        cache_.erase(texture->cacheKey_);
+    }
+
     auto it = std::find_if(datas_.begin(), datas_.end(),
                            [&](const std::unique_ptr<Texture>& t) {
                                 return t.get() == texture;
                            });
     if (it != datas_.end()) {
-        Context::Instance().device.waitIdle();
+        // frames in flight or a running upload may still use the image
+        uint64_t uploadValue = texture->uploadValue_.load(std::memory_order_relaxed);
+        std::unique_ptr<Texture> retired = std::move(*it);
         datas_.erase(it);
-        return;
+        Context::Instance().deletionQueue->Retire(std::move(retired), uploadValue);
     }
 }
 
@@ -13,6 +13,9 @@ void Init(std::vector<const char*>& extensions, Context::GetSurfaceCallback cb,
     ctx.initGraphicsPipeline();
     ctx.swapchain->InitFramebuffers();
     ctx.initCommandPool();
+    ctx.initUploadQueue();
+    ctx.initStagingPool();
+    ctx.initDeletionQueue();
     ctx.initSampler();
 
     int maxFlightCount = 2;
@@ -25,6 +28,8 @@ void Quit() {
     Context::Instance().device.waitIdle();
     renderer_.reset();
     TextureManager::Instance().Clear();
+    // releases may free descriptor sets, they have to run before the manager goes
+    Context::Instance().deletionQueue->Flush();
     DescriptorSetManager::Quit();
     Context::Quit();
 }
@@ -33,6 +38,18 @@ Texture* LoadTexture(const std::string& filename) {
     return TextureManager::Instance().Load(filename);
 }
 
+Texture* LoadTexture(const AssetArchive& archive, const std::string& name) {
+    return TextureManager::Instance().Load(archive, name);
+}
+
+Texture* LoadTextureAsync(const std::string& filename) {
+    return TextureManager::Instance().LoadAsync(filename);
+}
+
+std::vector<Texture*> LoadTextures(const std::vector<std::string>& filenames) {
+    return TextureManager::Instance().LoadTextures(filenames);
+}
+
 void DestroyTexture(Texture* texture) {
     TextureManager::Instance().Destroy(texture);
 }
@@ -0,0 +1,90 @@
+#include "toy2d/upload_queue.hpp"
+#include "toy2d/context.hpp"
+
+namespace toy2d {
+
+UploadQueue::UploadQueue() {
+    auto& ctx = Context::Instance();
+    cmdMgr_ = std::make_unique<CommandManager>(ctx.queueInfo.transferIndex.value());
+
+    vk::SemaphoreTypeCreateInfo typeInfo;
+    typeInfo.setSemaphoreType(vk::SemaphoreType::eTimeline)
+            .setInitialValue(0);
+    vk::SemaphoreCreateInfo createInfo;
+    createInfo.setPNext(&typeInfo);
+    semaphore_ = ctx.device.createSemaphore(createInfo);
+}
+
+UploadQueue::~UploadQueue() {
+    auto& device = Context::Instance().device;
+    if (open_) {
+        openBatch_.cmd.end();
+        cmdMgr_->FreeCmd(openBatch_.cmd);
+        open_ = false;
+    }
+    if (!pendingBatches_.empty()) {
+        Wait(pendingBatches_.back().value);
+    }
+    pendingBatches_.clear();
+    device.destroySemaphore(semaphore_);
+    cmdMgr_.reset();
+}
+
+vk::CommandBuffer UploadQueue::GetCommandBuffer() {
+    if (!open_) {
+        openBatch_.cmd = cmdMgr_->CreateOneCommandBuffer();
+        openBatch_.value = nextValue_;
+        vk::CommandBufferBeginInfo beginInfo;
+        beginInfo.setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
+        openBatch_.cmd.begin(beginInfo);
+        open_ = true;
+    }
+    return openBatch_.cmd;
+}
+
+void UploadQueue::Submit() {
+    if (!open_) {
+        return;
+    }
+
+    openBatch_.cmd.end();
+
+    vk::TimelineSemaphoreSubmitInfo timelineInfo;
+    timelineInfo.setSignalSemaphoreValues(openBatch_.value);
+    vk::SubmitInfo submitInfo;
+    submitInfo.setCommandBuffers(openBatch_.cmd)
+              .setSignalSemaphores(semaphore_)
+              .setPNext(&timelineInfo);
+    Context::Instance().transferQueue.submit(submitInfo);
+
+    pendingBatches_.push_back(openBatch_);
+    open_ = false;
+    nextValue_++;
+}
+
+void UploadQueue::Collect() {
+    uint64_t completed = GetCompletedValue();
+    while (!pendingBatches_.empty() && pendingBatches_.front().value <= completed) {
+        cmdMgr_->FreeCmd(pendingBatches_.front().cmd);
+        pendingBatches_.pop_front();
+    }
+}
+
+uint64_t UploadQueue::GetCompletedValue() const {
+    return Context::Instance().device.getSemaphoreCounterValue(semaphore_);
+}
+
+void UploadQueue::Wait(uint64_t value) {
+    if (open_ && value >= openBatch_.value) {
+        Submit();
+    }
+
+    vk::SemaphoreWaitInfo waitInfo;
+    waitInfo.setSemaphores(semaphore_)
+            .setValues(value);
+    if (Context::Instance().device.waitSemaphores(waitInfo, UINT64_MAX) != vk::Result::eSuccess) {
+        throw std::runtime_error("wait for upload failed");
+    }
+}
+
+}
@@ -0,0 +1,71 @@
+#include "toy2d/worker_pool.hpp"
+
+namespace toy2d {
+
+WorkerPool::WorkerPool(uint32_t workerCount) {
+    for (uint32_t i = 0; i < workerCount; i++) {
+        threads_.emplace_back(&WorkerPool::work, this, i);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        quit_ = true;
+    }
+    taskCond_.notify_all();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+void WorkerPool::Enqueue(Task task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push(std::move(task));
+        pending_++;
+    }
+    taskCond_.notify_one();
+}
+
+void WorkerPool::Wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    doneCond_.wait(lock, [this]() { return pending_ == 0; });
+    if (exception_) {
+        auto exception = exception_;
+        exception_ = nullptr;
+        std::rethrow_exception(exception);
+    }
+}
+
+void WorkerPool::work(uint32_t worker) {
+    while (true) {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            taskCond_.wait(lock, [this]() { return quit_ || !tasks_.empty(); });
+            if (tasks_.empty()) {
+                return;
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop();
+        }
+
+        std::exception_ptr exception;
+        try {
+            task(worker);
+        } catch (...) {
+            exception = std::current_exception();
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (exception && !exception_) {
+            exception_ = exception;
+        }
+        if (--pending_ == 0) {
+            doneCond_.notify_all();
+        }
+    }
+}
+
+}
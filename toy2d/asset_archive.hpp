@@ -0,0 +1,79 @@
+#pragma once
+
+#include "mapped_file.hpp"
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+namespace toy2d {
+
+// An asset archive packs many images into one file, written by the packer tool
+// (packer/). Images are stored ready for upload, RGBA8 pixels or compressed
+// blocks, so loading one is a lookup and a copy into staging memory. Layout:
+//   ArchiveHeader
+//   ArchiveEntry[entryCount]
+//   uint32_t[bucketCount]    open addressing table of entry indices by name hash
+//   names
+//   image data, every image aligned to ArchiveAlignment
+// All numbers are little endian.
+constexpr char ArchiveMagic[4] = {'T', '2', 'D', 'A'};
+// 2: RGBA8 images are stored with premultiplied alpha
+constexpr uint32_t ArchiveVersion = 2;
+constexpr uint32_t ArchiveAlignment = 64;
+constexpr uint32_t ArchiveEmptyBucket = 0xFFFFFFFF;
+
+struct ArchiveHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t bucketCount;  // a power of two
+    uint64_t entriesOffset;
+    uint64_t bucketsOffset;
+};
+
+struct ArchiveEntry {
+    uint64_t nameHash;
+    uint64_t nameOffset;
+    uint64_t dataOffset;
+    uint64_t dataSize;
+    uint32_t nameLength;
+    uint32_t format;      // a vk::Format
+    uint32_t width;
+    uint32_t height;
+    uint32_t levelCount;  // levels are stored back to back, level 0 first
+    uint32_t padding;
+};
+
+static_assert(sizeof(ArchiveHeader) == 32, "archive header layout changed");
+static_assert(sizeof(ArchiveEntry) == 56, "archive entry layout changed");
+
+// FNV-1a, used for the bucket table
+uint64_t HashAssetName(std::string_view name);
+
+// read only view of a mapped archive, throws if the file isn't a valid archive
+class AssetArchive final {
+public:
+    explicit AssetArchive(const std::string& filename);
+
+    // nullptr if no image of this name was packed
+    const ArchiveEntry* Find(std::string_view name) const;
+    const char* GetData(const ArchiveEntry& entry) const { return file_.Data() + entry.dataOffset; }
+    std::string_view GetName(const ArchiveEntry& entry) const {
+        return std::string_view(file_.Data() + entry.nameOffset, entry.nameLength);
+    }
+
+    uint32_t GetEntryCount() const { return header_->entryCount; }
+    const ArchiveEntry& GetEntry(uint32_t index) const { return entries_[index]; }
+    const std::string& GetFilename() const { return filename_; }
+
+private:
+    std::string filename_;
+    MappedFile file_;
+    const ArchiveHeader* header_ = nullptr;
+    const ArchiveEntry* entries_ = nullptr;
+    const uint32_t* buckets_ = nullptr;
+
+    bool inRange(uint64_t offset, uint64_t size) const;
+};
+
+}
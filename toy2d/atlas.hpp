@@ -0,0 +1,31 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace toy2d {
+
+// skyline bottom-left rectangle packer for one atlas page
+class SkylinePacker final {
+public:
+    SkylinePacker(uint32_t width, uint32_t height);
+
+    // find a place for a w x h rect, return false if the page is too full
+    bool Pack(uint32_t w, uint32_t h, uint32_t& x, uint32_t& y);
+
+private:
+    // a horizontal segment of the skyline, [x, x + w) is filled up to y
+    struct Node {
+        uint32_t x, y, w;
+    };
+
+    uint32_t width_;
+    uint32_t height_;
+    std::vector<Node> skyline_;
+
+    bool fit(size_t index, uint32_t w, uint32_t h, uint32_t& y) const;
+    void addLevel(size_t index, uint32_t x, uint32_t y, uint32_t w, uint32_t h);
+};
+
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "toy2d/math.hpp"
+#include "toy2d/buffer.hpp"
+#include "toy2d/texture.hpp"
+#include "toy2d/frame_allocator.hpp"
+#include "toy2d/state_cache.hpp"
+#include "toy2d/draw_list.hpp"
+#include "toy2d/cull.hpp"
+#include "toy2d/sprite_scene.hpp"
+#include <vector>
+
+namespace toy2d {
+
+// merges sprites and lines into as few draws as possible and records them
+// into one command buffer. Every command buffer recorded at the same time
+// needs its own Batcher, they are not thread safe.
+class Batcher final {
+public:
+    // what batches bind, owned by the Renderer and shared by all batchers of a frame
+    struct FrameResources {
+        FrameAllocator* allocator = nullptr;
+        vk::DescriptorSet uniformSet;
+        Buffer* rectVertices = nullptr;
+        Buffer* rectIndices = nullptr;
+        Texture* whiteTexture = nullptr;
+        bool bindless = false;
+        // sprites and lines outside the bounds are dropped when a batch is flushed
+        bool culling = false;
+        ViewBounds bounds = {};
+    };
+
+    void Begin(vk::CommandBuffer, const FrameResources&);
+    void SetBindless(bool bindless);
+    // later flushes cull against bounds
+    void SetBounds(const ViewBounds& bounds) { resources_.bounds = bounds; }
+
+    void AddSprite(const SpriteInstance&, Texture&);
+    void AddLine(const Vertex& p1, const Vertex& p2);
+    void AddIndirect(const DrawList::IndirectData&);
+    void AddScene(const SpriteScene&);
+    // sort the list, batch everything in it and clear it
+    void Record(DrawList&);
+    void Flush();
+
+    const StateCache::Stats& GetStats() const { return stateCache_.GetStats(); }
+    const CullStats& GetCullStats() const { return cullStats_; }
+
+private:
+    StateCache stateCache_;
+    FrameResources resources_;
+
+    std::vector<SpriteInstance> instances_;
+    Texture* texture_ = nullptr;
+    std::vector<Vertex> lineVertices_;
+
+    // bounding rects of the pending instances and lines, in the same order
+    RectArrays spriteRects_;
+    RectArrays lineRects_;
+    std::vector<uint8_t> visible_;
+    std::vector<uint32_t> visibleIndices_;
+    CullStats cullStats_;
+
+    template <typename T>
+    size_t cull(const RectArrays& rects, std::vector<T>& elements, size_t elementsPerRect);
+    // sprite pipeline, quad, instances and the sets not depending on a texture
+    void bindSprites(vk::Buffer instances);
+    void flushSprites();
+    // upload and draw instances_ as they are
+    void drawSprites();
+    void flushLines();
+    FrameAllocator::Allocation bufferFrameData(const void* data, size_t size, size_t alignment);
+};
+
+}
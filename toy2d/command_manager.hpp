@@ -5,13 +5,17 @@
 
 namespace toy2d {
 
+// owns one command pool. Pools must not be used from several threads at
+// once, threads recording in parallel each need their own CommandManager.
 class CommandManager final {
 public:
     CommandManager();
+    // pool for another queue family, e.g. the transfer family
+    explicit CommandManager(std::uint32_t queueFamilyIndex);
     ~CommandManager();
 
     vk::CommandBuffer CreateOneCommandBuffer();
-    std::vector<vk::CommandBuffer> CreateCommandBuffers(std::uint32_t count);
+    std::vector<vk::CommandBuffer> CreateCommandBuffers(std::uint32_t count, vk::CommandBufferLevel level = vk::CommandBufferLevel::ePrimary);
     void ResetCmds();
     void FreeCmd(const vk::CommandBuffer&);
 
@@ -21,7 +25,7 @@ public:
 private:
     vk::CommandPool pool_;
 
-    vk::CommandPool createCommandPool();
+    vk::CommandPool createCommandPool(std::uint32_t queueFamilyIndex);
 };
 
 }
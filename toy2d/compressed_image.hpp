@@ -0,0 +1,39 @@
+#pragma once
+
+#include "vulkan/vulkan.hpp"
+#include "mapped_file.hpp"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace toy2d {
+
+// block compressed image read from a KTX2 or DDS file, the blocks stay in the
+// mapped file and are copied to the GPU without decoding
+struct CompressedImage {
+    struct Level {
+        size_t offset;  // into file
+        size_t size;
+        uint32_t width;
+        uint32_t height;
+    };
+
+    vk::Format format = vk::Format::eUndefined;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<Level> levels;
+    MappedFile file;
+};
+
+// bytes of one level, for RGBA8 and the block formats below. 0 for other formats
+size_t ImageLevelSize(vk::Format, uint32_t w, uint32_t h);
+// levels of a full mip chain down to 1x1, images can't have more
+uint32_t MaxLevelCount(uint32_t w, uint32_t h);
+
+// true for .ktx2 and .dds files
+bool IsCompressedImageFile(const std::string& filename);
+
+// supports BC1, BC3, BC7 and ETC2 2D images without supercompression, throws otherwise
+CompressedImage LoadCompressedImage(const std::string& filename);
+
+}
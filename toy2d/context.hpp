@@ -6,13 +6,18 @@
 #include <functional>
 #include <vector>
 #include <array>
+#include <algorithm>
 
 #include "vulkan/vulkan.hpp"
 #include "swapchain.hpp"
 #include "render_process.hpp"
 #include "tool.hpp"
+#include "mapped_file.hpp"
 #include "command_manager.hpp"
 #include "shader.hpp"
+#include "upload_queue.hpp"
+#include "staging_pool.hpp"
+#include "deletion_queue.hpp"
 
 namespace toy2d {
 
@@ -29,17 +34,36 @@ public:
     struct QueueInfo {
         std::optional<std::uint32_t> graphicsIndex;
         std::optional<std::uint32_t> presentIndex;
+        // a transfer only family if the device has one, the graphics family otherwise
+        std::optional<std::uint32_t> transferIndex;
     } queueInfo;
 
+    struct BindlessInfo {
+        static constexpr uint32_t MaxTextureCount = 4096;
+
+        bool supported = false;
+        uint32_t maxTextureCount = 0;
+    } bindlessInfo;
+
+    // timeline semaphores (core since Vulkan 1.2) are needed for async uploads
+    bool timelineSupported = false;
+
     vk::Instance instance;
     vk::PhysicalDevice phyDevice;
     vk::Device device;
     vk::Queue graphicsQueue;
     vk::Queue presentQueue;
+    vk::Queue transferQueue;
     std::unique_ptr<Swapchain> swapchain;
     std::unique_ptr<RenderProcess> renderProcess;
     std::unique_ptr<CommandManager> commandManager;
     std::unique_ptr<Shader> shader;
+    // nullptr if timeline semaphores are not supported, textures upload synchronously then
+    std::unique_ptr<UploadQueue> uploadQueue;
+    // staging memory of all uploads
+    std::unique_ptr<StagingPool> stagingPool;
+    // resources released while frames may still use them
+    std::unique_ptr<DeletionQueue> deletionQueue;
     vk::Sampler sampler;
 
 private:
@@ -55,6 +79,9 @@ private:
     void initSwapchain(int windowWidth, int windowHeight);
     void initGraphicsPipeline();
     void initCommandPool();
+    void initUploadQueue();
+    void initStagingPool();
+    void initDeletionQueue();
     void initShaderModules();
     void initSampler();
     void getSurface();
@@ -64,6 +91,8 @@ private:
     vk::Device createDevice(vk::SurfaceKHR);
 
     void queryQueueInfo(vk::SurfaceKHR);
+    void queryBindlessInfo();
+    void queryTimelineInfo();
 };
 
 }
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace toy2d {
+
+// visible area in world space
+struct ViewBounds {
+    float minX, minY, maxX, maxY;
+};
+
+struct CullStats {
+    uint32_t drawn = 0;
+    uint32_t culled = 0;
+
+    CullStats& operator+=(const CullStats& o) {
+        drawn += o.drawn;
+        culled += o.culled;
+        return *this;
+    }
+};
+
+// rects as structure of arrays, so they can be tested several at a time
+struct RectArrays {
+    std::vector<float> x, y;          // center
+    std::vector<float> halfW, halfH;  // half extents, not negative
+
+    void Push(float centerX, float centerY, float halfWidth, float halfHeight);
+    void Clear();
+    size_t Size() const { return x.size(); }
+};
+
+// visible[i] is set to 1 if rect i overlaps bounds and to 0 otherwise,
+// returns the number of visible rects. Uses AVX2 or SSE2 when compiled with them.
+size_t CullRects(const RectArrays& rects, const ViewBounds& bounds, uint8_t* visible);
+
+}
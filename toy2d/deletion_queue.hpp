@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace toy2d {
+
+// releases GPU resources once nothing in flight can use them anymore, instead of
+// waiting for the device to idle. A release pushed while frame N is recorded (or
+// after it was submitted) runs once the fence of frame N signaled, see
+// Renderer::StartRender. With an upload value it also waits for the upload queue
+// to reach it. Releases run on the thread starting frames
+class DeletionQueue final {
+public:
+    using Release = std::function<void()>;
+
+    // everything has to be flushed by now, see Quit()
+    ~DeletionQueue();
+
+    // safe to call from any thread
+    void Push(Release, uint64_t uploadValue = 0);
+
+    // keeps the object alive until its release runs
+    template <typename T>
+    void Retire(std::unique_ptr<T> object, uint64_t uploadValue = 0) {
+        std::shared_ptr<T> retired(std::move(object));
+        Push([retired]() mutable { retired.reset(); }, uploadValue);
+    }
+
+    // frame numbers start at 1, releases pushed before the first frame belong to frame 0
+    void BeginFrame(uint64_t frame);
+    // runs the releases of frames up to completedFrame whose uploads finished
+    void Collect(uint64_t completedFrame);
+    // runs every release, only once the device is idle
+    void Flush();
+
+private:
+    struct Entry {
+        uint64_t frame;
+        uint64_t uploadValue;
+        Release release;
+    };
+
+    std::vector<Entry> entries_;
+    uint64_t frame_ = 0;
+    std::mutex mutex_;
+};
+
+}
@@ -33,6 +33,17 @@ public:
 
     void FreeImageSet(const SetInfo&);
 
+    // sets of the culling compute shader, see Shader::GetCullDescriptorSetLayout()
+    SetInfo AllocCullSet();
+    void FreeCullSet(const SetInfo&);
+
+    uint32_t GetMaxFlight() const { return maxFlight_; }
+
+    // bindless texture table, only valid when Context::bindlessInfo.supported
+    vk::DescriptorSet GetTextureTableSet() const { return textureTable_.set; }
+    uint32_t AllocTextureIndex(vk::ImageView, vk::Sampler);
+    void FreeTextureIndex(uint32_t index);
+
 private:
     struct PoolInfo {
         vk::DescriptorPool pool_;
@@ -47,8 +58,16 @@ private:
     void addImageSetPool();
     PoolInfo& getAvaliableImagePoolInfo();
 
+    std::vector<PoolInfo> cullSetPools_;
+
     uint32_t maxFlight_;
 
+    SetInfo textureTable_;
+    std::vector<uint32_t> freeTextureIndices_;
+    uint32_t nextTextureIndex_ = 0;
+
+    void createTextureTable();
+
     static std::unique_ptr<DescriptorSetManager> instance_;
 };
 
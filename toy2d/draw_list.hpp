@@ -0,0 +1,98 @@
+#pragma once
+
+#include "toy2d/math.hpp"
+#include "toy2d/texture.hpp"
+#include "toy2d/sprite_scene.hpp"
+#include <vector>
+#include <cstdint>
+
+namespace toy2d {
+
+// CPU side list of draw packets, sorted by a 64-bit key before recording
+//
+//  63        48 47    44 43            20 19          0
+// +------------+--------+----------------+-------------+
+// |   layer    |pipeline|    texture     |    depth    |
+// +------------+--------+----------------+-------------+
+//
+// layer is the most significant field, so blended sprites on a higher layer
+// are always drawn after lower layers. Inside one layer packets are grouped
+// by pipeline and texture to make batches as large as possible. The sort is
+// stable, packets with equal keys keep their submission order.
+//
+// A list is not thread safe, but different lists can be filled on different
+// threads and handed to Renderer::Submit(), see Renderer::SetWorkerCount().
+class DrawList final {
+public:
+    enum class Pipeline : uint8_t {
+        Sprite = 0,
+        Line = 1,
+        SpriteBuffer = 2,
+        SpriteScene = 3,
+    };
+
+    struct Packet {
+        uint64_t key;
+        uint32_t index; // into the array of the packet's pipeline field
+    };
+
+    struct SpriteData {
+        SpriteInstance instance;
+        Texture* texture;
+    };
+
+    struct LineData {
+        Vertex p1, p2;
+    };
+
+    // sprites culled on the GPU, drawn with one indirect draw
+    struct IndirectData {
+        vk::Buffer instances;
+        vk::Buffer drawCommand;
+        Texture* texture; // only sampled without the bindless table
+    };
+
+    static Pipeline GetPipeline(const Packet& packet) {
+        return static_cast<Pipeline>((packet.key >> 44) & 0xF);
+    }
+
+    void SetLayer(uint16_t layer) { layer_ = layer; }
+    // in [0, 1], orders packets sharing layer, pipeline and texture, smaller first
+    void SetDepth(float depth);
+
+    void AddSprite(const SpriteInstance&, Texture&);
+    void AddLine(const Vertex& p1, const Vertex& p2);
+    void AddIndirect(const IndirectData&);
+    void AddScene(const SpriteScene&);
+
+    // same as the Renderer functions, for lists filled away from the render thread
+    void SetDrawColor(const Color& color) { color_ = color; }
+    void DrawTexture(const Rect&, Texture&);
+    void DrawLine(const Vec& p1, const Vec& p2);
+
+    void Sort();
+    void Clear();
+
+    bool Empty() const { return packets_.empty(); }
+    const std::vector<Packet>& GetPackets() const { return packets_; }
+    const SpriteData& GetSprite(const Packet& packet) const { return sprites_[packet.index]; }
+    const LineData& GetLine(const Packet& packet) const { return lines_[packet.index]; }
+    const IndirectData& GetIndirect(const Packet& packet) const { return indirects_[packet.index]; }
+    const SpriteScene* GetScene(const Packet& packet) const { return scenes_[packet.index]; }
+
+private:
+    uint16_t layer_ = 0;
+    uint32_t depth_ = 0;
+    Color color_ = {1, 1, 1};
+
+    std::vector<Packet> packets_;
+    std::vector<Packet> sortBuffer_;
+    std::vector<SpriteData> sprites_;
+    std::vector<LineData> lines_;
+    std::vector<IndirectData> indirects_;
+    std::vector<const SpriteScene*> scenes_;
+
+    uint64_t makeKey(Pipeline, uint32_t textureId) const;
+};
+
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "toy2d/buffer.hpp"
+#include <memory>
+#include <vector>
+#include <mutex>
+
+namespace toy2d {
+
+// linear allocator over one persistently mapped host visible buffer,
+// one per frame in flight. Everything allocated lives until Reset(),
+// which must only be called after the frame's fence has signaled.
+// Allocate() may be called from several recording threads at once.
+class FrameAllocator final {
+public:
+    struct Allocation {
+        vk::Buffer buffer;
+        vk::DeviceSize offset;
+        void* map;
+    };
+
+    FrameAllocator(size_t size);
+
+    Allocation Allocate(size_t size, size_t alignment = 16);
+    void Reset();
+
+    size_t GetCapacity() const { return buffer_->size; }
+    size_t GetUsedSize() const { return offset_; }
+
+private:
+    std::unique_ptr<Buffer> buffer_;
+    std::vector<std::unique_ptr<Buffer>> retiredBuffers_;
+    size_t offset_ = 0;
+    std::mutex mutex_;
+
+    void grow(size_t minSize);
+};
+
+}
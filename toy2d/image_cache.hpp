@@ -0,0 +1,59 @@
+#pragma once
+
+#include "mapped_file.hpp"
+#include <string>
+#include <cstdint>
+
+namespace toy2d {
+
+constexpr char ImageCacheMagic[4] = {'T', '2', 'D', 'I'};
+// 2: pixels are stored with premultiplied alpha
+constexpr uint32_t ImageCacheVersion = 2;
+
+// header of a cache entry, the RGBA8 pixels follow it
+struct ImageCacheHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint64_t sourceSize;
+    int64_t sourceTime;
+};
+static_assert(sizeof(ImageCacheHeader) == 32);
+
+// decoded pixels of image files kept on disk, so later runs map them instead of
+// decoding the file again. Entries are keyed by the canonical path, size and
+// modification time of the source, editing an image makes its old entry unreachable.
+// The directory can be deleted at any time
+class ImageDiskCache final {
+public:
+    struct Entry {
+        MappedFile file;
+        uint32_t width = 0;
+        uint32_t height = 0;
+
+        bool IsOpen() const { return file.IsOpen(); }
+        const uint8_t* Pixels() const {
+            return reinterpret_cast<const uint8_t*>(file.Data()) + sizeof(ImageCacheHeader);
+        }
+    };
+
+    // creates the directory if it's missing
+    explicit ImageDiskCache(const std::string& directory);
+
+    // the entry stays closed if the file was never cached or changed since
+    Entry Find(const std::string& filename) const;
+    // pixels are w * h RGBA8. Failing to write only costs the next run a decode,
+    // it's not reported. Safe to call from several threads
+    void Store(const std::string& filename, const void* pixels, uint32_t w, uint32_t h) const;
+
+    const std::string& GetDirectory() const { return directory_; }
+
+private:
+    std::string directory_;
+
+    // false if the source can't be read
+    bool entryPath(const std::string& filename, std::string& path, uint64_t& size, int64_t& time) const;
+};
+
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <cstddef>
+
+namespace toy2d {
+
+// read only mapping of a whole file. The pages come straight from the page cache
+// and are shared with every other process mapping the file, nothing is copied
+// into the heap. Failing to map leaves the file closed, see IsOpen()
+class MappedFile final {
+public:
+    // how the mapping will be read, passed to the kernel as a paging hint
+    enum class Access {
+        Sequential,
+        Random,
+    };
+
+    MappedFile() = default;
+    explicit MappedFile(const std::string& filename, Access access = Access::Sequential);
+    ~MappedFile();
+
+    MappedFile(MappedFile&&) noexcept;
+    MappedFile& operator=(MappedFile&&) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool IsOpen() const { return data_ != nullptr; }
+    const char* Data() const { return data_; }
+    size_t Size() const { return size_; }
+    std::string_view View() const { return std::string_view(data_, size_); }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+#ifdef _WIN32
+    void* file_ = nullptr;
+    void* mapping_ = nullptr;
+#endif
+
+    void close();
+};
+
+}
@@ -15,13 +15,17 @@ struct Vec final {
     static std::vector<vk::VertexInputBindingDescription> GetBindingDescription();
 };
 
+struct Color final {
+    float r, g, b;
+
+    // RGBA8888 packed, alpha is always 0xFF
+    uint32_t Pack() const;
+};
+
 struct Vertex final {
     Vec position;
     Vec texcoord;
-};
-
-struct Color final {
-    float r, g, b;
+    Color color;
 };
 
 using Size = Vec;
@@ -55,4 +59,17 @@ struct Rect {
     Size size;
 };
 
+// per-instance data of one sprite drawn on the shared unit quad
+struct SpriteInstance final {
+    Vec position;
+    Size size;
+    Rect uv;
+    uint32_t color;
+    // slot in the bindless texture table, ignored when drawing with per-texture sets
+    uint32_t texture;
+
+    static std::vector<vk::VertexInputAttributeDescription> GetAttributeDescription();
+    static std::vector<vk::VertexInputBindingDescription> GetBindingDescription();
+};
+
 }
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace toy2d {
+
+// multiplies the color of every RGBA8 pixel by its alpha in place, rounded like
+// c * a / 255. The pipeline blends premultiplied colors. Uses AVX2 or SSE2 when
+// compiled with them.
+// The multiply happens on the stored sRGB values, as image editors export them
+void PremultiplyAlpha(uint8_t* pixels, size_t pixelCount);
+
+}
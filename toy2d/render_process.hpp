@@ -10,20 +10,30 @@ class RenderProcess {
 public:
     vk::Pipeline graphicsPipelineWithTriangleTopology = nullptr;
     vk::Pipeline graphicsPipelineWithLineTopology = nullptr;
+    // instanced sprites sampling the bindless texture table, null if not supported
+    vk::Pipeline graphicsPipelineWithBindlessTexture = nullptr;
     vk::RenderPass renderPass = nullptr;
     vk::PipelineLayout layout = nullptr;
+    // culls sprite buffers and writes their indirect draw, see SpriteBuffer
+    vk::Pipeline computePipelineWithCulling = nullptr;
+    vk::PipelineLayout cullLayout = nullptr;
 
     RenderProcess();
     ~RenderProcess();
 
     void CreateGraphicsPipeline(const Shader& shader);
+    void CreateComputePipeline(const Shader& shader);
     void CreateRenderPass();
 
 private:
     vk::PipelineCache pipelineCache_ = nullptr;
 
     vk::PipelineLayout createLayout();
-    vk::Pipeline createGraphicsPipeline(const Shader& shader, vk::PrimitiveTopology);
+    vk::Pipeline createGraphicsPipeline(vk::ShaderModule vertexModule,
+                                        vk::ShaderModule fragModule,
+                                        vk::PrimitiveTopology,
+                                        const std::vector<vk::VertexInputAttributeDescription>&,
+                                        const std::vector<vk::VertexInputBindingDescription>&);
     vk::RenderPass createRenderPass();
     vk::PipelineCache createPipelineCache();
 };
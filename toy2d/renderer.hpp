@@ -7,7 +7,15 @@
 #include "toy2d/math.hpp"
 #include "toy2d/buffer.hpp"
 #include "toy2d/texture.hpp"
+#include "toy2d/frame_allocator.hpp"
+#include "toy2d/state_cache.hpp"
+#include "toy2d/draw_list.hpp"
+#include "toy2d/batcher.hpp"
+#include "toy2d/worker_pool.hpp"
+#include "toy2d/sprite_buffer.hpp"
+#include "toy2d/sprite_scene.hpp"
 #include <limits>
+#include <mutex>
 
 namespace toy2d {
 
@@ -17,33 +25,120 @@ public:
     ~Renderer();
 
     void SetProject(int right, int left, int bottom, int top, int far, int near);
+
+    // camera: position is the world point mapped to the projection space origin,
+    // zoom scales the world around it. Cheap enough to call every frame, the matrices
+    // are written into this frame's uniform buffer and apply to the whole frame
+    void SetView(const Vec& position, float zoom = 1);
+    // move the camera by delta world units
+    void Pan(const Vec& delta);
+    // scale the current zoom by factor, keeping the center of the view in place
+    void Zoom(float factor);
+    const Vec& GetViewPosition() const { return viewPosition_; }
+    float GetViewZoom() const { return viewZoom_; }
+
+    // textures still uploading asynchronously are skipped
     void DrawTexture(const Rect&, Texture& texture);
     void DrawLine(const Vec& p1, const Vec& p2);
     void SetDrawColor(const Color&);
+    // cull the sprites on the GPU and draw the visible ones with one indirect draw.
+    // Sprites sample their own texture through the bindless table, without it all of them
+    // sample texture. Draw a SpriteBuffer at most once per frame.
+    void DrawSpriteBuffer(SpriteBuffer&, Texture* texture = nullptr);
+    // upload what changed in the scene since it was drawn last and draw its sprites,
+    // with culling on only the ones its grid finds inside the projection bounds.
+    // Its textures must be ready, see Texture::IsReady
+    void DrawSpriteScene(SpriteScene&);
+
+    // deferred draws are captured and sorted in EndRender, see DrawList for the order
+    void SetDeferred(bool deferred) { deferred_ = deferred; }
+    void SetLayer(uint16_t layer) { drawList_.SetLayer(layer); }
+    void SetDepth(float depth) { drawList_.SetDepth(depth); }
+
+    // hand a list filled on any thread to the current frame, it is recorded in EndRender
+    // after the Renderer's own draws and cleared. The list must stay alive until then.
+    // Thread safe, lists are recorded in the order they were submitted.
+    void Submit(DrawList&);
+
+    // record the frame's draw lists in parallel, each on a worker thread into its own
+    // secondary command buffer. 0 records everything on the calling thread.
+    // While workers are used Renderer draws are deferred. Don't call inside a frame.
+    void SetWorkerCount(uint32_t count);
+    uint32_t GetWorkerCount() const { return workerPool_ ? workerPool_->GetWorkerCount() : 0; }
+    // the recording threads, can also be used to fill draw lists. nullptr without workers
+    WorkerPool* GetWorkerPool() { return workerPool_.get(); }
+
+    // draw sprites with different textures in one batch through the bindless texture table,
+    // on by default, ignored if the device doesn't support descriptor indexing
+    void SetBindless(bool bindless);
+    bool IsBindless() const { return bindless_; }
 
     void StartRender();
     void EndRender();
 
+    // counters of the last finished frame, including how many binds were skipped,
+    // summed over all command buffers
+    const StateCache::Stats& GetFrameStats() const { return frameStats_; }
+
+    // drop sprites and lines outside the projection bounds before they are uploaded,
+    // on by default. Takes effect in the next StartRender
+    void SetCulling(bool culling) { culling_ = culling; }
+    bool IsCulling() const { return culling_; }
+    // sprites and lines drawn and culled in the last finished frame, sprite buffers not included
+    const CullStats& GetCullStats() const { return cullStats_; }
+
 private:
     int maxFlightCount_;
     int curFrame_;
+    // frames started so far, the deletion queue tracks releases by it
+    uint64_t frameNumber_ = 0;
     uint32_t imageIndex_;
     std::vector<vk::Fence> fences_;
     std::vector<vk::Semaphore> imageAvaliableSems_;
     std::vector<vk::Semaphore> renderFinishSems_;
     std::vector<vk::CommandBuffer> cmdBufs_;
+    // recorded outside the render pass and submitted before cmdBufs_, for compute and transfer work
+    std::vector<vk::CommandBuffer> prepassCmdBufs_;
+    bool prepassUsed_ = false;
+    std::vector<std::unique_ptr<FrameAllocator>> frameAllocators_;
     std::unique_ptr<Buffer> rectVerticesBuffer_;
     std::unique_ptr<Buffer> rectIndicesBuffer_;
-    std::unique_ptr<Buffer> lineVerticesBuffer_;
     Mat4 projectMat_;
+    ViewBounds projectBounds_;
+    // projectBounds_ in world space, after the camera
+    ViewBounds viewBounds_;
     Mat4 viewMat_;
+    Vec viewPosition_ = {0, 0};
+    float viewZoom_ = 1;
+    // host visible, written each frame once its fence has signaled
     std::vector<std::unique_ptr<Buffer>> uniformBuffers_;
-    std::vector<std::unique_ptr<Buffer>> deviceUniformBuffers_;
+    bool inFrame_ = false;
     std::vector<DescriptorSetManager::SetInfo> descriptorSets_;
     vk::Sampler sampler;
     Texture* whiteTexture;
     Color drawColor_ = {1, 1, 1};
 
+    bool deferred_ = false;
+    bool bindless_ = false;
+    DrawList drawList_;
+    std::vector<DrawList*> submittedLists_;
+    std::mutex submitMutex_;
+
+    Batcher batcher_;
+    StateCache::Stats frameStats_;
+    bool culling_ = true;
+    CullStats cullStats_;
+
+    // per worker thread recording state of one frame in flight
+    struct Recorder {
+        std::unique_ptr<CommandManager> cmdMgr;
+        std::vector<vk::CommandBuffer> cmdBufs;
+        uint32_t usedCount = 0;
+        Batcher batcher;
+    };
+    std::unique_ptr<WorkerPool> workerPool_;
+    std::vector<std::vector<Recorder>> recorders_; // [frame][worker]
+
     void createFences();
     void createSemaphores();
     void createCmdBuffers();
@@ -51,15 +146,16 @@ private:
     void createUniformBuffers(int flightCount);
 
     void bufferRectData();
-    void bufferRectVertexData();
-    void bufferRectIndicesData();
-
-    void bufferLineData(const Vec& p1, const Vec& p2);
+    void beginRenderPass(vk::SubpassContents);
+    Batcher::FrameResources getFrameResources();
+    void recordParallel();
+    void recordCulling(SpriteBuffer&);
 
     void bufferMVPData();
+    void updateView();
     void initMats();
     void updateDescriptorSets();
-    void transformBuffer2Device(Buffer& src, Buffer& dst, size_t srcOffset, size_t dstOffset, size_t size);
+    void transformBuffer2Device(vk::Buffer src, Buffer& dst, size_t srcOffset, size_t dstOffset, size_t size);
     void createWhiteTexture();
 
     std::uint32_t queryBufferMemTypeIndex(std::uint32_t, vk::MemoryPropertyFlags);
@@ -2,24 +2,42 @@
 
 #include "vulkan/vulkan.hpp"
 #include <vector>
+#include <string_view>
 
 namespace toy2d {
 
 class Shader {
 public:
-    Shader(const std::vector<char>& vertexSource, const std::vector<char>& fragSource);
+    // sources are SPIR-V views, 4 byte aligned. bindlessFragSource is only used
+    // when Context::bindlessInfo.supported
+    Shader(std::string_view vertexSource,
+           std::string_view spriteVertexSource,
+           std::string_view fragSource,
+           std::string_view bindlessFragSource,
+           std::string_view cullCompSource);
     ~Shader();
 
     vk::ShaderModule GetVertexModule() const { return vertexModule_; }
+    vk::ShaderModule GetSpriteVertexModule() const { return spriteVertexModule_; }
     vk::ShaderModule GetFragModule() const { return fragModule_; }
+    vk::ShaderModule GetBindlessFragModule() const { return bindlessFragModule_; }
+    vk::ShaderModule GetCullCompModule() const { return cullCompModule_; }
 
     const std::vector<vk::DescriptorSetLayout>& GetDescriptorSetLayouts() const { return layouts_; }
     std::vector<vk::PushConstantRange> GetPushConstantRange() const;
 
+    // the sprite culling compute shader, see SpriteBuffer
+    vk::DescriptorSetLayout GetCullDescriptorSetLayout() const { return cullLayout_; }
+    std::vector<vk::PushConstantRange> GetCullPushConstantRange() const;
+
 private:
     vk::ShaderModule vertexModule_;
+    vk::ShaderModule spriteVertexModule_;
     vk::ShaderModule fragModule_;
+    vk::ShaderModule bindlessFragModule_ = nullptr;
+    vk::ShaderModule cullCompModule_;
     std::vector<vk::DescriptorSetLayout> layouts_;
+    vk::DescriptorSetLayout cullLayout_;
 
     void initDescriptorSetLayouts();
 };
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "toy2d/math.hpp"
+#include "toy2d/cull.hpp"
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+
+namespace toy2d {
+
+// hashed uniform grid over rects, each id is stored in every cell its rect
+// overlaps. Only non-empty cells are kept, so the world has no fixed size.
+// Moving a rect inside the cells it already covers only updates its bounds.
+// Rects covering more than MaxItemCells cells are kept in a list of their own and
+// tested by every query, so one huge background doesn't fill millions of cells.
+class SpatialGrid final {
+public:
+    SpatialGrid(float cellSize = 256);
+
+    // rect.position is the center. ids are small integers, they index an array
+    void Insert(uint32_t id, const Rect&);
+    void Move(uint32_t id, const Rect&);
+    void Remove(uint32_t id);
+    void Clear();
+
+    // append the ids of rects overlapping bounds or containing point, each id once
+    void QueryRect(const ViewBounds& bounds, std::vector<uint32_t>& result) const;
+    void QueryPoint(const Vec& point, std::vector<uint32_t>& result) const;
+
+    float GetCellSize() const { return cellSize_; }
+
+    static constexpr int64_t MaxItemCells = 64;
+
+private:
+    // cell coordinates are clamped to this, far away rects share the border cells
+    static constexpr int32_t MaxCell = 1 << 30;
+
+    struct CellRange {
+        int32_t minX, minY, maxX, maxY;
+
+        bool operator==(const CellRange& o) const {
+            return minX == o.minX && minY == o.minY && maxX == o.maxX && maxY == o.maxY;
+        }
+    };
+
+    struct Item {
+        ViewBounds bounds;
+        CellRange cells;
+        bool valid = false;
+        bool large = false;
+        uint32_t largeIndex = 0;  // into largeItems_
+    };
+
+    float cellSize_;
+    std::vector<Item> items_;
+    std::unordered_map<uint64_t, std::vector<uint32_t>> cells_;
+    std::vector<uint32_t> largeItems_;
+
+    static uint64_t cellKey(int32_t x, int32_t y);
+    static ViewBounds toBounds(const Rect&);
+    int32_t toCell(float coord) const;
+    CellRange toCellRange(const ViewBounds&) const;
+    static int64_t cellCount(const CellRange&);
+    void addToCells(uint32_t id, const CellRange&);
+    void removeFromCells(uint32_t id, const CellRange&);
+    void link(uint32_t id);
+    void unlink(uint32_t id);
+    // reports id if its cell range has (x, y) as first cell shared with range
+    void reportFromCell(int32_t x, int32_t y, const CellRange& range, const std::vector<uint32_t>& ids,
+                        const ViewBounds& bounds, std::vector<uint32_t>& result) const;
+};
+
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "toy2d/math.hpp"
+#include "toy2d/buffer.hpp"
+#include "toy2d/descriptor_manager.hpp"
+#include "toy2d/frame_allocator.hpp"
+#include <memory>
+#include <vector>
+
+namespace toy2d {
+
+// sprite instances kept in device local memory and drawn without CPU work per sprite.
+// Each frame a compute pass culls them against the projection bounds and writes the
+// visible ones together with their indirect draw command, see Renderer::DrawSpriteBuffer().
+// The order of the visible sprites is not kept, it suits particles and other
+// content where overlapping sprites may blend in any order.
+class SpriteBuffer final {
+public:
+    SpriteBuffer(uint32_t capacity);
+    ~SpriteBuffer();
+
+    SpriteBuffer(const SpriteBuffer&) = delete;
+    SpriteBuffer& operator=(const SpriteBuffer&) = delete;
+
+    // copy instances into [first, first + count). Returns at once, the copy is recorded
+    // into the next frame drawing the buffer, before its culling pass
+    void Upload(const SpriteInstance* instances, uint32_t count, uint32_t first = 0);
+    // number of sprites drawn, starting from the first one
+    void SetCount(uint32_t count);
+
+    uint32_t GetCount() const { return count_; }
+    uint32_t GetCapacity() const { return capacity_; }
+    vk::Buffer GetBuffer() const { return sprites_->buffer; }
+
+private:
+    friend class Renderer;
+
+    // written by the culling pass, one per frame in flight
+    struct FrameData {
+        std::unique_ptr<Buffer> visibleSprites;
+        std::unique_ptr<Buffer> drawCommand;
+        DescriptorSetManager::SetInfo set;
+    };
+
+    uint32_t capacity_;
+    uint32_t count_ = 0;
+    std::unique_ptr<Buffer> sprites_;
+    std::vector<FrameData> frames_;
+    // uploads not recorded yet, regions point into pending_
+    std::vector<SpriteInstance> pending_;
+    std::vector<vk::BufferCopy> pendingRegions_;
+
+    void updateDescriptorSet(FrameData&);
+    // copies the pending uploads through allocator, outside of a render pass
+    void recordUpload(vk::CommandBuffer, FrameAllocator& allocator);
+};
+
+}
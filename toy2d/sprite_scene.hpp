@@ -0,0 +1,79 @@
+#pragma once
+
+#include "toy2d/math.hpp"
+#include "toy2d/buffer.hpp"
+#include "toy2d/texture.hpp"
+#include "toy2d/frame_allocator.hpp"
+#include "toy2d/spatial_grid.hpp"
+#include <memory>
+#include <vector>
+#include <limits>
+
+namespace toy2d {
+
+// retained sprites for content that mostly stays the same between frames.
+// Instances live in a device local buffer, drawing the scene only uploads
+// the pages changed since it was drawn last, see Renderer::DrawSpriteScene().
+// Sprites are drawn in creation order, destroying one moves the last sprite
+// into its place. Don't modify a scene between drawing it and EndRender.
+// A SpatialGrid over the sprite rects answers visibility and picking queries.
+class SpriteScene final {
+public:
+    using Handle = uint32_t;
+    static constexpr Handle InvalidHandle = std::numeric_limits<Handle>::max();
+
+    SpriteScene(uint32_t capacity, float gridCellSize = 256);
+    ~SpriteScene();
+
+    SpriteScene(const SpriteScene&) = delete;
+    SpriteScene& operator=(const SpriteScene&) = delete;
+
+    // rect.position is the sprite center, like Renderer::DrawTexture
+    Handle Create(const Rect&, Texture&, const Color& color = {1, 1, 1});
+    void Destroy(Handle);
+
+    void SetRect(Handle, const Rect&);
+    void SetColor(Handle, const Color&);
+    void SetTexture(Handle, Texture&);
+
+    uint32_t GetCount() const { return instances_.size(); }
+    uint32_t GetCapacity() const { return capacity_; }
+    vk::Buffer GetBuffer() const { return buffer_->buffer; }
+    const std::vector<SpriteInstance>& GetInstances() const { return instances_; }
+    const std::vector<Texture*>& GetTextures() const { return textures_; }
+
+    // append the handles of sprites overlapping bounds or containing point
+    void QueryRect(const ViewBounds& bounds, std::vector<Handle>& result) const { grid_.QueryRect(bounds, result); }
+    void QueryPoint(const Vec& point, std::vector<Handle>& result) const { grid_.QueryPoint(point, result); }
+    // indices into GetInstances() of sprites overlapping bounds, in draw order
+    void GatherVisible(const ViewBounds& bounds, std::vector<uint32_t>& indices) const;
+
+    // copy the changed pages into the device buffer through allocator, recorded
+    // outside of a render pass. Barriers for the vertex input reading it are included
+    void RecordUpload(vk::CommandBuffer, FrameAllocator& allocator);
+
+private:
+    static constexpr uint32_t PageSize = 64; // instances
+
+    uint32_t capacity_;
+    std::unique_ptr<Buffer> buffer_;
+
+    // dense, in draw order
+    std::vector<SpriteInstance> instances_;
+    std::vector<Texture*> textures_;
+    std::vector<Handle> handles_;
+
+    // handle -> index into the dense arrays
+    std::vector<uint32_t> indices_;
+    std::vector<Handle> freeHandles_;
+
+    SpatialGrid grid_;
+
+    std::vector<bool> dirtyPages_;
+    bool dirty_ = false;
+
+    uint32_t getIndex(Handle) const;
+    void markDirty(uint32_t index);
+};
+
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "vulkan/vulkan.hpp"
+#include <memory>
+#include <vector>
+#include <deque>
+#include <mutex>
+
+namespace toy2d {
+
+struct Buffer;
+
+// ring over one persistently mapped host visible buffer, shared by every upload.
+// Allocations are handed out in order and reclaimed in order once the GPU
+// finished reading them, so uploads don't allocate and map memory of their own.
+class StagingPool final {
+public:
+    struct Allocation {
+        vk::Buffer buffer;
+        vk::DeviceSize offset;
+        void* map;
+    };
+
+    StagingPool(vk::DeviceSize size);
+    ~StagingPool();
+
+    Allocation Allocate(vk::DeviceSize size, vk::DeviceSize alignment = 16);
+    // the allocation can be reused once the upload queue reached uploadValue,
+    // 0 means the GPU is done with it already (e.g. after ExecuteCmd)
+    void Release(const Allocation&, uint64_t uploadValue = 0);
+
+    vk::DeviceSize GetCapacity() const;
+
+private:
+    struct Region {
+        Buffer* buffer;
+        vk::DeviceSize begin;
+        vk::DeviceSize end;
+        uint64_t uploadValue;
+        bool released;
+    };
+
+    std::unique_ptr<Buffer> buffer_;
+    // replaced by grow(), kept until all their regions are reclaimed
+    std::vector<std::unique_ptr<Buffer>> retiredBuffers_;
+    // oldest first, the regions of retired buffers come before the current buffer's
+    std::deque<Region> regions_;
+    std::mutex mutex_;
+
+    void reclaim();
+    bool fit(vk::DeviceSize size, vk::DeviceSize alignment, vk::DeviceSize& offset);
+    void grow(vk::DeviceSize minSize);
+};
+
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "vulkan/vulkan.hpp"
+#include <array>
+
+namespace toy2d {
+
+// records through a command buffer and skips binds of state that is
+// already bound. Call Begin() whenever the command buffer starts recording,
+// bound state doesn't survive across command buffers.
+class StateCache final {
+public:
+    struct Stats {
+        uint32_t drawCalls = 0;
+        uint32_t pipelineBinds = 0;
+        uint32_t elidedPipelineBinds = 0;
+        uint32_t vertexBufferBinds = 0;
+        uint32_t elidedVertexBufferBinds = 0;
+        uint32_t indexBufferBinds = 0;
+        uint32_t elidedIndexBufferBinds = 0;
+        uint32_t descriptorSetBinds = 0;
+        uint32_t elidedDescriptorSetBinds = 0;
+        uint32_t pushConstants = 0;
+        uint32_t elidedPushConstants = 0;
+
+        Stats& operator+=(const Stats&);
+    };
+
+    void Begin(vk::CommandBuffer);
+
+    void BindPipeline(vk::Pipeline, vk::PipelineLayout);
+    void BindVertexBuffer(uint32_t binding, vk::Buffer, vk::DeviceSize offset);
+    void BindIndexBuffer(vk::Buffer, vk::DeviceSize offset, vk::IndexType);
+    void BindDescriptorSet(uint32_t set, vk::DescriptorSet);
+    void PushConstants(vk::ShaderStageFlags, uint32_t offset, uint32_t size, const void* data);
+
+    void Draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance);
+    void DrawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance);
+    void DrawIndexedIndirect(vk::Buffer, vk::DeviceSize offset, uint32_t drawCount, uint32_t stride);
+
+    vk::CommandBuffer GetCommandBuffer() const { return cmd_; }
+    const Stats& GetStats() const { return stats_; }
+
+private:
+    static constexpr uint32_t MaxVertexBindings = 4;
+    static constexpr uint32_t MaxDescriptorSets = 4;
+    static constexpr uint32_t MaxPushConstantSize = 128;
+
+    struct VertexBinding {
+        vk::Buffer buffer;
+        vk::DeviceSize offset = 0;
+    };
+
+    vk::CommandBuffer cmd_;
+    vk::Pipeline pipeline_;
+    vk::PipelineLayout layout_;
+    std::array<VertexBinding, MaxVertexBindings> vertexBindings_;
+    vk::Buffer indexBuffer_;
+    vk::DeviceSize indexOffset_ = 0;
+    vk::IndexType indexType_ = vk::IndexType::eUint32;
+    std::array<vk::DescriptorSet, MaxDescriptorSets> descriptorSets_;
+    std::array<char, MaxPushConstantSize> pushConstants_;
+    // bytes that have been pushed, only those can be compared against
+    std::array<bool, MaxPushConstantSize> pushConstantsValid_;
+
+    Stats stats_;
+
+    void invalidateLayoutState();
+};
+
+}
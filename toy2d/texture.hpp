@@ -3,8 +3,18 @@
 #include "vulkan/vulkan.hpp"
 #include "buffer.hpp"
 #include "descriptor_manager.hpp"
+#include "atlas.hpp"
+#include "math.hpp"
+#include "worker_pool.hpp"
+#include "compressed_image.hpp"
+#include "mapped_file.hpp"
+#include "asset_archive.hpp"
+#include "image_cache.hpp"
+#include "premultiply.hpp"
 #include <string_view>
 #include <string>
+#include <atomic>
+#include <unordered_map>
 
 namespace toy2d {
 
@@ -19,22 +29,63 @@ public:
     vk::DeviceMemory memory;
     vk::ImageView view;
     DescriptorSetManager::SetInfo set;
+    // unique while the texture lives, used to order draws by texture
+    uint32_t id = 0;
+    // slot in the bindless texture table, if bindless is supported
+    uint32_t bindlessIndex = 0;
+    // region of the image this texture covers, a sub rect for textures packed into an atlas
+    Rect uv = {Vec{0, 0}, Size{1, 1}};
+
+    // false while an async upload of the image is still running, the renderer
+    // skips textures which are not ready
+    bool IsReady() const;
+    // blocks until the image is uploaded
+    void WaitReady();
 
 private:
-    Texture(std::string_view filename);
+    // the atlas page owning the image, textures in an atlas share all vulkan objects with it
+    Texture* atlasPage_ = nullptr;
+    // upload queue value signaled once the image is uploaded, 0 if it's resident
+    mutable std::atomic<uint64_t> uploadValue_{0};
+    uint32_t mipLevels_ = 1;
+    vk::Format format_ = vk::Format::eR8G8B8A8Srgb;
+    // canonical path the texture is cached under, empty for created textures
+    std::string cacheKey_;
+    // loads sharing the texture, it's released when the last one is destroyed
+    uint32_t refCount_ = 0;
+
+    // data can be nullptr, the image is cleared to transparent black then
+    Texture(void* data, uint32_t w, uint32_t h, bool mipmaps = false);
+
+    // records the upload into the open batch of uploads instead of waiting for it
+    Texture(void* data, uint32_t w, uint32_t h, UploadQueue&, bool mipmaps);
 
-    Texture(void* data, uint32_t w, uint32_t h);
+    // uploads prepared levels as they are, compressed blocks or RGBA8 pixels.
+    // Level offsets are relative to data
+    Texture(vk::Format, uint32_t w, uint32_t h, const std::vector<CompressedImage::Level>& levels, const char* data);
 
-    void createImage(uint32_t w, uint32_t h);
+    Texture(Texture& atlasPage, const Rect& uv);
+
+    // creates the image without content, its layout stays undefined until something uploads to it
+    Texture(uint32_t w, uint32_t h, bool shared, bool mipmaps);
+
+    void createResources(uint32_t w, uint32_t h, bool shared, bool mipmaps);
+    void createImage(uint32_t w, uint32_t h, bool shared);
     void createImageView();
     void allocMemory();
     uint32_t queryImageMemoryIndex();
-    void transitionImageLayoutFromUndefine2Dst();
-    void transitionImageLayoutFromDst2Optimal();
-    void transformData2Image(Buffer&, uint32_t w, uint32_t h);
+    vk::ImageMemoryBarrier layoutBarrier(vk::ImageLayout oldLayout, vk::ImageLayout newLayout,
+                                         vk::AccessFlags srcAccess, vk::AccessFlags dstAccess,
+                                         uint32_t baseMip = 0, uint32_t mipCount = VK_REMAINING_MIP_LEVELS);
+    void transitionImageLayoutFromUndefine2Dst(vk::CommandBuffer);
+    void transitionImageLayoutFromDst2Optimal(vk::CommandBuffer, vk::PipelineStageFlags dstStage, vk::AccessFlags dstAccess);
+    void transformData2Image(vk::CommandBuffer, vk::Buffer, uint32_t w, uint32_t h, vk::DeviceSize offset);
+    void clearImage(vk::CommandBuffer);
+    // fills the levels below 0 and leaves every level in shader read layout
+    void generateMipmaps(vk::CommandBuffer, uint32_t w, uint32_t h, vk::PipelineStageFlags dstStage, vk::AccessFlags dstAccess);
     void updateDescriptorSet();
 
-    void init(void* data, uint32_t w, uint32_t h);
+    void init(void* data, uint32_t w, uint32_t h, UploadQueue* uploads, bool mipmaps);
 };
 
 class TextureManager final {
@@ -46,17 +97,87 @@ public:
         return *instance_;
     }
 
+    // .ktx2 and .dds files are loaded as block compressed textures (BC1/BC3/BC7/ETC2),
+    // everything else is decoded to RGBA8 and premultiplied, like the blending expects.
+    // Compressed textures ignore atlas mode and mipmaps, they bring their own levels,
+    // and have to be exported with premultiplied alpha.
+    // All loads are cached by canonical path: loading a file again returns the same
+    // texture and takes a reference, Destroy releases one
     Texture* Load(const std::string& filename);
+    // returns at once, the texture becomes ready when the transfer queue finished
+    // uploading it, see Texture::IsReady. Falls back to Load without timeline semaphores
+    Texture* LoadAsync(const std::string& filename);
+    // loads a packed image without decoding, cached like files. The image keeps the
+    // levels it was packed with, atlas mode and mipmaps don't apply
+    Texture* Load(const AssetArchive&, const std::string& name);
+    // decodes the images in parallel and uploads all of them with one submit, the
+    // textures are returned in the order of filenames. With async the upload goes
+    // through the transfer queue like LoadAsync, otherwise it returns once it finished
+    std::vector<Texture*> LoadTextures(const std::vector<std::string>& filenames, bool async = false);
+
+    // pack small images into shared atlas pages, so they batch together and
+    // don't pay for their own image, memory and descriptor set
+    void SetAtlasMode(bool enable) { atlasMode_ = enable; }
+    // give textures loaded from now on a full mip chain, so sprites drawn much smaller
+    // than their image (zoomed out views) sample small levels. Atlas pages and async
+    // uploads on a separate transfer queue keep one level
+    void SetMipmaps(bool enable);
+    // keep decoded pixels of loaded files in this directory, later runs read them back
+    // instead of decoding the images again. An empty directory turns the cache off
+    void SetDiskCache(const std::string& directory);
 
-    // data must be a RGBA8888 format data
+    // whether textures of this format can be sampled with linear filtering, e.g. to
+    // pick BC or ETC2 assets for the device
+    static bool IsFormatSupported(vk::Format);
+
+    // data must be a RGBA8888 format data with premultiplied alpha, see PremultiplyAlpha
     Texture* Create(void* data, uint32_t w, uint32_t h);
+    // frees created textures, loaded ones once their last reference is destroyed.
+    // Doesn't wait for the GPU, the image is released after the frames using it finished
     void Destroy(Texture*);
     void Clear();
 
 private:
+    static constexpr uint32_t AtlasPageSize = 2048;
+    // images larger than this in any dimension always get their own texture
+    static constexpr uint32_t MaxAtlasImageSize = 256;
+    // empty border around every packed image, so linear filtering doesn't pick up neighbours
+    static constexpr uint32_t AtlasPadding = 1;
+
+    struct AtlasPage {
+        std::unique_ptr<Texture> texture;
+        SkylinePacker packer;
+    };
+
+    // copy of a packed image from staging memory into its atlas page
+    struct AtlasCopy {
+        Texture* page;
+        vk::BufferImageCopy region;
+    };
+
     static std::unique_ptr<TextureManager> instance_;
 
     std::vector<std::unique_ptr<Texture>> datas_;
+    std::vector<AtlasPage> atlasPages_;
+    std::unordered_map<std::string, Texture*> cache_;
+    uint32_t nextId_ = 0;
+    bool atlasMode_ = false;
+    bool mipmaps_ = false;
+    // decodes images for LoadTextures, created on first use
+    std::unique_ptr<WorkerPool> decodePool_;
+    std::unique_ptr<ImageDiskCache> diskCache_;
+
+    WorkerPool& getDecodePool();
+    static std::string cacheKey(const std::string& filename);
+    Texture* acquireCached(const std::string& key);
+    void addToCache(const std::string& key, Texture*);
+    Texture* loadFile(const std::string& filename);
+    Texture* loadCompressed(const std::string& filename);
+    std::vector<Texture*> loadDecoded(const std::vector<std::string>& filenames, bool async);
+    // packs the image and adds its copy from offset in the staging buffer to copies
+    Texture* loadIntoAtlas(uint32_t w, uint32_t h, vk::DeviceSize offset, std::vector<AtlasCopy>& copies);
+    // records all copies into one submit
+    void copyToAtlas(vk::Buffer, const std::vector<AtlasCopy>&);
 };
 
 }
@@ -11,6 +11,9 @@ namespace toy2d {
 void Init(std::vector<const char*>& extensions, Context::GetSurfaceCallback, int windowWidth, int windowHeight);
 void Quit();
 Texture* LoadTexture(const std::string& filename);
+Texture* LoadTexture(const AssetArchive&, const std::string& name);
+Texture* LoadTextureAsync(const std::string& filename);
+std::vector<Texture*> LoadTextures(const std::vector<std::string>& filenames);
 void DestroyTexture(Texture*);
 void ResizeSwapchainImage(int w, int h);
 Renderer* GetRenderer();
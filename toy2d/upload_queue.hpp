@@ -0,0 +1,48 @@
+#pragma once
+
+#include "vulkan/vulkan.hpp"
+#include "toy2d/command_manager.hpp"
+#include <memory>
+#include <deque>
+
+namespace toy2d {
+
+// records uploads into batches submitted to the transfer queue. Every batch
+// signals the next value of a timeline semaphore, so resources can ask whether
+// their upload finished without blocking and the renderer can wait for it on the GPU.
+class UploadQueue final {
+public:
+    UploadQueue();
+    ~UploadQueue();
+
+    // command buffer of the open batch, a new batch is begun if none is open
+    vk::CommandBuffer GetCommandBuffer();
+    // value the timeline semaphore reaches once the open batch finished
+    uint64_t GetBatchValue() const { return nextValue_; }
+    // submit the open batch, does nothing if no batch is open
+    void Submit();
+    // release command buffers of finished batches
+    void Collect();
+
+    uint64_t GetCompletedValue() const;
+    bool IsComplete(uint64_t value) const { return value <= GetCompletedValue(); }
+    // blocks until the batch with this value finished, submits it first if it is still open
+    void Wait(uint64_t value);
+
+    vk::Semaphore GetSemaphore() const { return semaphore_; }
+
+private:
+    struct Batch {
+        vk::CommandBuffer cmd;
+        uint64_t value;
+    };
+
+    std::unique_ptr<CommandManager> cmdMgr_;
+    vk::Semaphore semaphore_;
+    Batch openBatch_;
+    bool open_ = false;
+    std::deque<Batch> pendingBatches_;
+    uint64_t nextValue_ = 1;
+};
+
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <queue>
+#include <vector>
+#include <exception>
+#include <cstdint>
+
+namespace toy2d {
+
+// fixed set of threads running tasks from one queue. Tasks get the index of
+// the worker running them, so per-thread resources can be kept in arrays.
+class WorkerPool final {
+public:
+    using Task = std::function<void(uint32_t worker)>;
+
+    WorkerPool(uint32_t workerCount);
+    ~WorkerPool();
+
+    void Enqueue(Task task);
+    // block until every enqueued task finished, rethrows the first exception a task threw
+    void Wait();
+
+    uint32_t GetWorkerCount() const { return threads_.size(); }
+
+private:
+    std::vector<std::thread> threads_;
+    std::queue<Task> tasks_;
+    std::mutex mutex_;
+    std::condition_variable taskCond_;
+    std::condition_variable doneCond_;
+    uint32_t pending_ = 0;
+    bool quit_ = false;
+    std::exception_ptr exception_;
+
+    void work(uint32_t worker);
+};
+
+}